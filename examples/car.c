@@ -1,8 +1,12 @@
 #include <ncurses.h>
 #include <stdio.h>
 #include <stdlib.h>  // rand/srand
+#include <string.h>  // memset
 #include <time.h>    // time
 #include "ledcurses.h"
+#include "ledgrid.h"
+#include "ledsim.h"
+#include "ledsprite.h"
 
 #define max(a, b) ({__typeof__(a) _a = (a); \
                     __typeof__(b) _b = (b); \
@@ -33,18 +37,46 @@ void show_info(WINDOW *win, const char *fmt, ...) {
 #define GAME_END        0
 #define GAME_RESTART    1
 
-int car_game(LEDMatrix *lm, WINDOW *info_win, int prob) {
+#define OPAQUE 255 // no transparent pixels
+
+static const uint8_t car_pixels[] = {CAR_COLOR};
+static const LEDSprite car_sprite = {1, 1, car_pixels, NULL, 0};
+
+// Obstacles live both in a grid (for collisions) and in a bitmap (for drawing)
+static uint8_t obstacle_pixels[led_rows*led_cols];
+
+void set_obstacle(LEDGrid *obstacles, int row, int col, int on) {
+    if (on) {
+        led_grid_set(obstacles, row, col);
+    } else {
+        led_grid_clear(obstacles, row, col);
+    }
+    obstacle_pixels[row*led_cols + col] = on ? OBS_COLOR : 0;
+}
+
+void draw_obstacles(LEDMatrix *lm, int modulo_cycle) {
+    // The ring buffer's first row is shown at modulo_cycle, and it wraps around
+    LEDSprite head = {led_rows-modulo_cycle, led_cols, obstacle_pixels, NULL, OPAQUE};
+    LEDSprite tail = {modulo_cycle, led_cols, obstacle_pixels + (led_rows-modulo_cycle)*led_cols,
+                      NULL, OPAQUE};
+    led_blit_sprite(lm, &head, modulo_cycle, 0);
+    led_blit_sprite(lm, &tail, 0, 0);
+}
+
+int car_game(LEDMatrix *lm, LEDGrid *obstacles, WINDOW *info_win, int prob) {
     show_info(info_win, "---------------------------------\n");
     show_info(info_win, "Arrows to move. Press 'Q' to exit\n");
 
-    // Obstacles data structure
-    int obstacles[led_rows][led_cols] = {0};
+    // Obstacles data structure (rows are used as a ring buffer)
+    led_grid_reset(obstacles);
+    memset(obstacle_pixels, 0, sizeof(obstacle_pixels));
     for (int i=0; i<led_rows-5; i+=2) {
         int has_escape = 0;
         for (int j=0; j<led_cols; j++) {
             // Populate given a uniform distribution
-            obstacles[i][j] = (rand()%100) < prob ? OBS_COLOR : 0;
-            if (!obstacles[i][j]) {
+            if ((rand()%100) < prob) {
+                set_obstacle(obstacles, i, j, 1);
+            } else {
                 has_escape = 1;
             }
         }
@@ -52,7 +84,7 @@ int car_game(LEDMatrix *lm, WINDOW *info_win, int prob) {
         // Salvation for all-in-a-row obstacles
         if (!has_escape) {
             int escape = rand() % 4;
-            obstacles[i][escape] = 0;
+            set_obstacle(obstacles, i, escape, 0);
         }
 #endif
     }
@@ -70,13 +102,7 @@ int car_game(LEDMatrix *lm, WINDOW *info_win, int prob) {
 
     while (1) {
         int modulo_cycle = cycle % led_rows;
-        // draw obstacles
-        for (int i=0; i<led_rows; i++) {
-            for (int j=0; j<led_cols; j++) {
-                led_diode_set_value(lm, i, j, obstacles[(led_rows+i-modulo_cycle)%led_rows][j]);
-
-            }
-        }
+        draw_obstacles(lm, modulo_cycle);
 
         switch (led_getch(lm)) {
             case KEY_LEFT:
@@ -100,10 +126,10 @@ int car_game(LEDMatrix *lm, WINDOW *info_win, int prob) {
         car_col = (car_col >= led_cols) ? led_cols-1 : (car_col < 0 ? 0 : car_col);
 
         // draw car
-        led_diode_set_value(lm, car_row, car_col, CAR_COLOR);
+        led_blit_sprite(lm, &car_sprite, car_row, car_col);
         led_draw(lm);
 
-        napms(TICK);
+        led_napms(lm, TICK);
 
         if (running) {
             ticks_this_cycle++;
@@ -115,16 +141,16 @@ int car_game(LEDMatrix *lm, WINDOW *info_win, int prob) {
 
         if (ticks_this_cycle >= ticks_per_update) {
             ticks_this_cycle = 0;
-            for (int j=0; j<led_cols; j++) {
-                // Check collision
-                if (obstacles[(led_rows+car_row-modulo_cycle)%led_rows][car_col]) {
-                    led_diode_set_attrs(lm, car_row, car_col, A_REVERSE);
-                    led_draw(lm);
-                    running = 0;
-                }
+            // Check collision
+            if (led_grid_test(obstacles, (led_rows+car_row-modulo_cycle)%led_rows, car_col)) {
+                led_diode_set_attrs(lm, car_row, car_col, A_REVERSE);
+                led_draw(lm);
+                running = 0;
+            }
 
+            for (int j=0; j<led_cols; j++) {
                 // Clear outgoing obstacles
-                obstacles[(2*led_rows-1-modulo_cycle)%led_rows][j] = 0;
+                set_obstacle(obstacles, (2*led_rows-1-modulo_cycle)%led_rows, j, 0);
             }
 
             if (cycle%2 == 0) {
@@ -132,13 +158,13 @@ int car_game(LEDMatrix *lm, WINDOW *info_win, int prob) {
                 int new_row_index = (led_rows-1-modulo_cycle)%led_rows;
                 int has_escape = 0;
                 for(int j=0; j<led_cols; j++) {
-                    obstacles[new_row_index][j] = (rand()%100) < prob ? OBS_COLOR : 0;
+                    set_obstacle(obstacles, new_row_index, j, (rand()%100) < prob);
                 }
 #if !(IM_FEELIN_LUCKY)
                 // Salvation
                 if (!has_escape) {
                     int escape = rand() % 4;
-                    obstacles[new_row_index][escape] = 0;
+                    set_obstacle(obstacles, new_row_index, escape, 0);
                 }
 #endif
                 if (cycle%100 == 0) {
@@ -166,36 +192,63 @@ int main(int argc, char *argv[]) {
     int info_rows = 5;
     int win_rows = -info_rows; // Negative X means "full size minus X"
 
+    // Simulation mode: LEDCURSES_SIM holds a key script (see ledsim.h), and the game
+    // runs headless on a virtual clock, printing a hash per frame when it's over
+    const char *sim_script = getenv("LEDCURSES_SIM");
+    LEDSim sim;
+    WINDOW *info_win = NULL;
     LEDMatrix lm;
-    int err = led_init(&lm, led_rows /* rows of leds */, led_cols /* cols of leds */,
-                            win_rows /* terminal rows */, 0 /* max terminal cols */,
-                            0 /* window begin row */, 0 /* window begin col */,
-                            0 /* you start ncurses */, 0 /*debug*/);
-    if (err) {
-        fprintf(stderr, "\nError starting LEDCurses\n");
-        fprintf(stderr, "Lines: %d\nwin_rows: %d\ninfo_rows: %d\n", LINES, win_rows, info_rows);
-        return 1;
+    if (sim_script) {
+        if (led_sim_init(&sim, 1 << 20) || led_sim_parse_script(&sim, sim_script) ||
+            led_init_headless(&lm, led_rows, led_cols, led_rows*3, led_cols*6, NULL, 0)) {
+            fprintf(stderr, "Error starting the simulation\n");
+            return 1;
+        }
+        sim.quit_key = 'q';
+        led_sim_attach(&lm, &sim);
+    } else {
+        int err = led_init(&lm, led_rows /* rows of leds */, led_cols /* cols of leds */,
+                                win_rows /* terminal rows */, 0 /* max terminal cols */,
+                                0 /* window begin row */, 0 /* window begin col */,
+                                0 /* you start ncurses */, 0 /*debug*/);
+        if (err) {
+            fprintf(stderr, "\nError starting LEDCurses\n");
+            fprintf(stderr, "Lines: %d\nwin_rows: %d\ninfo_rows: %d\n", LINES, win_rows, info_rows);
+            return 1;
+        }
+        win_rows = lm.win_rows;
+
+        // Information window at the bottom
+        info_win = newwin(info_rows, 0, win_rows, 0);
+        if (!info_win) {
+            fprintf(stderr, "Couldn't create info window\n");
+            fprintf(stderr, "Lines: %d\nwin_rows: %d\ninfo_rows: %d\n", LINES, win_rows, info_rows);
+            return 1;
+        }
+        scrollok(info_win, 1);
+
+        // By default, color #1 is red
+        init_pair(CAR_COLOR, COLOR_BLUE, COLOR_BLACK);
+
+        keypad(lm.win, TRUE); // <-- Important for the arrows
+        nodelay(lm.win, TRUE); // <-- Important for time to run
+        curs_set(0);  // <-- Important because otherwise it's annoying
     }
-    win_rows = lm.win_rows;
 
-    // Information window at the bottom
-    WINDOW *info_win = newwin(info_rows, 0, win_rows, 0);
-    if (!info_win) {
-        fprintf(stderr, "Couldn't create info window\n");
-        fprintf(stderr, "Lines: %d\nwin_rows: %d\ninfo_rows: %d\n", LINES, win_rows, info_rows);
+    LEDGrid obstacles;
+    if (led_grid_init(&obstacles, &lm)) {
+        led_end(&lm);
+        fprintf(stderr, "Couldn't create the obstacles grid\n");
         return 1;
     }
-    scrollok(info_win, 1);
 
-    // By default, color #1 is red
-    init_pair(CAR_COLOR, COLOR_BLUE, COLOR_BLACK);
-
-    keypad(lm.win, TRUE); // <-- Important for the arrows
-    nodelay(lm.win, TRUE); // <-- Important for time to run
-    curs_set(0);  // <-- Important because otherwise it's annoying
-
-    while (car_game(&lm, info_win, prob) == GAME_RESTART);
+    while (car_game(&lm, &obstacles, info_win, prob) == GAME_RESTART);
+    led_grid_end(&obstacles);
     led_end(&lm);
 
+    if (sim_script) {
+        led_sim_write_hashes(&sim, stdout);
+        led_sim_end(&sim);
+    }
     return 0;
 }
@@ -0,0 +1,53 @@
+#include <ncurses.h>
+#include "ledcurses.h"
+#include "ledfx.h"
+
+#define TICK 16 // ms, about 60 FPS
+
+int main(int argc, char *argv[]) {
+    int led_rows, led_cols;
+    if (argc < 3) {
+        led_rows = 12; led_cols = 20;
+    } else {
+        led_rows = atoi(argv[1]); led_cols = atoi(argv[2]);
+    }
+    LEDMatrix lm;
+    int err = led_init(&lm, led_rows /* rows of leds */, led_cols /* cols of leds */,
+                            0 /* max terminal rows */, 0 /* terminal cols */,
+                            0 /* window begin row */, 0 /* window begin col */,
+                            0 /* you start ncurses */, 0 /*debug*/);
+    LEDFx fx;
+    if (err || led_fx_init(&fx, &lm)) {
+        led_end(&lm);
+        fprintf(stderr, "Error starting LEDCurses\n");
+        return 1;
+    }
+
+    // Off, then dim to bright
+    init_pair(2, COLOR_YELLOW, COLOR_BLACK);
+    init_pair(3, COLOR_WHITE, COLOR_BLACK);
+    int palette[4] = {0, 1, 2, 3};
+    led_fx_set_palette(&fx, palette, 4);
+
+    const LEDFxKernel *effects[] = {&led_fx_plasma, &led_fx_fire, &led_fx_noise, &led_fx_gradient};
+    int effect = 0;
+
+    nodelay(lm.win, TRUE); // <-- Important for time to run
+    while (1) {
+        led_fx_render(&fx, effects[effect]);
+        led_draw(&lm);
+
+        // Space for the next effect, 'q' to exit
+        int key = led_getch(&lm);
+        if (key == 'q') {
+            break;
+        } else if (key == ' ') {
+            effect = (effect + 1) % 4;
+        }
+        napms(TICK);
+    }
+
+    led_fx_end(&fx);
+    led_end(&lm);
+    return 0;
+}
@@ -0,0 +1,86 @@
+#include <math.h>
+#include <ncurses.h>
+#include "ledcurses.h"
+#include "ledprim.h"
+#include "ledquality.h"
+
+#define TICK 33 // ms, about 30 FPS
+#define N_BARS 6
+
+#define FRAME_COLOR 1   // red by default
+#define NEEDLE_COLOR 2
+#define BAR_COLOR 3
+
+// A dial, a bar chart and a line chart, redrawn from scratch every frame
+int main(int argc, char *argv[]) {
+    int led_rows, led_cols;
+    if (argc < 3) {
+        led_rows = 24; led_cols = 60;
+    } else {
+        led_rows = atoi(argv[1]); led_cols = atoi(argv[2]);
+    }
+    LEDMatrix lm;
+    if (led_init(&lm, led_rows /* rows of leds */, led_cols /* cols of leds */,
+                      0 /* max terminal rows */, 0 /* terminal cols */,
+                      0 /* window begin row */, 0 /* window begin col */,
+                      0 /* you start ncurses */, 0 /*debug*/)) {
+        fprintf(stderr, "Error starting LEDCurses\n");
+        return 1;
+    }
+    init_pair(NEEDLE_COLOR, COLOR_YELLOW, COLOR_BLACK);
+    init_pair(BAR_COLOR, COLOR_GREEN, COLOR_BLACK);
+    nodelay(lm.win, TRUE); // <-- Important for time to run
+    curs_set(0);
+
+    // Optional latency budget (ms): over slow links, frames get skipped and
+    // LEDs simplified until the terminal keeps up
+    LEDQuality quality;
+    int budget_ms = argc > 3 ? atoi(argv[3]) : 0;
+    if (budget_ms > 0 && led_quality_init(&quality, &lm, budget_ms)) {
+        budget_ms = 0;
+    }
+
+    // Dial on the left third, bars in the middle one, line chart on the right
+    int third = led_cols/3;
+    int radius = (led_rows < third ? led_rows : third)/2 - 1;
+    int dial_row = led_rows/2, dial_col = third/2;
+
+    for (int t=0; led_getch(&lm) != 'q'; t++) {
+        led_rect(&lm, 0, 0, led_rows, led_cols, 0, 1);
+
+        // Dial: circle, a hub, and a needle sweeping 270 degrees (clockwise from up)
+        double angle = M_PI*(-0.75 + 1.5*(0.5 + 0.5*sin(t*0.05)));
+        led_circle(&lm, dial_row, dial_col, radius, FRAME_COLOR, 0);
+        led_line(&lm, dial_row, dial_col, dial_row - (int)lround(radius*0.8*cos(angle)),
+                                          dial_col + (int)lround(radius*0.8*sin(angle)), NEEDLE_COLOR);
+        led_circle(&lm, dial_row, dial_col, 1, FRAME_COLOR, 1);
+
+        // Bars, in a frame
+        led_rect(&lm, 0, third, led_rows, third, FRAME_COLOR, 0);
+        int bar_cols = (third - 2)/N_BARS;
+        for (int b=0; b<N_BARS; b++) {
+            int height = (int)((led_rows - 2)*(0.5 + 0.5*sin(t*0.07 + b)));
+            led_rect(&lm, led_rows - 1 - height, third + 1 + b*bar_cols,
+                          height, bar_cols - 1, BAR_COLOR, 1);
+        }
+
+        // Line chart: a scrolling wave, joined by lines
+        int prev_row = 0;
+        for (int j=2*third; j<led_cols; j++) {
+            int row = (int)((led_rows - 1)*(0.5 - 0.45*sin((j + t)*0.2)));
+            if (j > 2*third) {
+                led_line(&lm, prev_row, j - 1, row, j, NEEDLE_COLOR);
+            }
+            prev_row = row;
+        }
+
+        led_draw(&lm);
+        led_napms(&lm, TICK);
+    }
+
+    if (budget_ms > 0) {
+        led_quality_end(&quality);
+    }
+    led_end(&lm);
+    return 0;
+}
@@ -0,0 +1,104 @@
+#include <ncurses.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ledcurses.h"
+#include "ledmono.h"
+#include "ledlife.h"
+#include "ledsim.h"
+#include "ledpresent.h"
+
+#define TICK 16 // ms, about 60 FPS
+
+// Cellular automaton screensaver: most LEDs change on every frame.
+// Space reseeds, 'w' toggles wrapping edges, 'q' quits.
+int main(int argc, char *argv[]) {
+    int led_rows, led_cols;
+    if (argc < 3) {
+        led_rows = 30; led_cols = 60;
+    } else {
+        led_rows = atoi(argv[1]); led_cols = atoi(argv[2]);
+    }
+    const char *rule = argc > 3 ? argv[3] : "B3/S23";
+    int percent = argc > 4 ? atoi(argv[4]) : 35;
+
+    // Simulation mode (see snake.c): headless, as fast as possible
+    const char *sim_script = getenv("LEDCURSES_SIM");
+    LEDSim sim;
+    LEDMatrix lm;
+    if (sim_script) {
+        if (led_sim_init(&sim, 1 << 20) || led_sim_parse_script(&sim, sim_script) ||
+            led_init_mono_headless(&lm, led_rows, led_cols, led_rows*3, led_cols*6, 1, NULL, 0)) {
+            fprintf(stderr, "Error starting the simulation\n");
+            return 1;
+        }
+        sim.quit_key = 'q';
+        led_sim_attach(&lm, &sim);
+    } else {
+        // A bit per LED: lit ones are drawn as diodes of value 1
+        if (led_init_mono(&lm, led_rows /* rows of leds */, led_cols /* cols of leds */,
+                               0 /* max terminal rows */, 0 /* terminal cols */,
+                               0 /* window begin row */, 0 /* window begin col */,
+                               0 /* you start ncurses */, 0 /*debug*/,
+                               1 /* value of lit LEDs */, NULL, 0)) {
+            fprintf(stderr, "Error starting LEDCurses\n");
+            return 1;
+        }
+        nodelay(lm.win, TRUE); // <-- Important for time to run
+        curs_set(0);
+    }
+
+    LEDMono mono;
+    LEDLife life;
+    if (led_mono_init(&mono, &lm)) {
+        led_end(&lm);
+        fprintf(stderr, "Couldn't create the framebuffer\n");
+        return 1;
+    }
+    if (led_life_init(&life, &mono, rule)) {
+        led_mono_end(&mono);
+        led_end(&lm);
+        fprintf(stderr, "Invalid rule %s (try B3/S23)\n", rule);
+        return 1;
+    }
+    led_life_randomize(&life, percent);
+
+    // LEDCURSES_ASYNC: draw from a presenter thread, the automaton never waits
+    // for the terminal (frames it can't keep up with are dropped)
+    LEDPresenter presenter;
+    int async = getenv("LEDCURSES_ASYNC") && !sim_script;
+    if (async && led_presenter_start(&presenter, &lm)) {
+        async = 0;
+    }
+
+    while (1) {
+        led_mono_draw(&mono);
+        led_life_step(&life);
+
+        int key = led_getch(&lm);
+        if (key == 'q') {
+            break;
+        } else if (key == ' ') {
+            led_life_randomize(&life, percent);
+        } else if (key == 'w') {
+            life.wrap = !life.wrap;
+        }
+        led_napms(&lm, TICK);
+    }
+
+    if (async) {
+        led_presenter_stop(&presenter);
+    }
+    led_life_end(&life);
+    led_mono_end(&mono);
+    led_end(&lm);
+    if (async) {
+        printf("%llu frames, %llu dropped\n", (unsigned long long)presenter.n_published,
+                                               (unsigned long long)presenter.n_dropped);
+    }
+
+    if (sim_script) {
+        led_sim_write_hashes(&sim, stdout);
+        led_sim_end(&sim);
+    }
+    return 0;
+}
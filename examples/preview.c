@@ -0,0 +1,58 @@
+#include <ncurses.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "ledcurses.h"
+#include "ledrecv.h"
+
+// Software preview of an Art-Net or E1.31 RGB stream, in 8 colors
+static int rgb_to_pair(const uint8_t *rgb, void *arg) {
+    // COLOR_RED, COLOR_GREEN and COLOR_BLUE are bits 0, 1 and 2
+    return (rgb[0] >= 128) | (rgb[1] >= 128) << 1 | (rgb[2] >= 128) << 2;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 4) {
+        fprintf(stderr, "Usage: %s artnet|e131 led_rows led_cols [port]\n", argv[0]);
+        return 1;
+    }
+    int protocol = !strcmp(argv[1], "e131") ? LED_RECV_E131 : LED_RECV_ARTNET;
+    int led_rows = atoi(argv[2]);
+    int led_cols = atoi(argv[3]);
+    int port = argc > 4 ? atoi(argv[4]) : 0;
+
+    LEDMatrix lm;
+    if (led_init(&lm, led_rows, led_cols,
+                      0 /* max terminal rows */, 0 /* max terminal cols */,
+                      0 /* window begin row */, 0 /* window begin col */,
+                      0 /* you start ncurses */, 0 /*debug*/)) {
+        fprintf(stderr, "Couldn't create the matrix\n");
+        return 1;
+    }
+    for (short c=1; c<8 && c<COLOR_PAIRS; c++) {
+        init_pair(c, c, COLOR_BLACK);
+    }
+    nodelay(lm.win, TRUE);
+
+    LEDReceiver rx;
+    if (led_recv_init(&rx, &lm, protocol, "127.0.0.1", port)) {
+        led_end(&lm);
+        fprintf(stderr, "Couldn't listen\n");
+        return 1;
+    }
+    led_recv_set_color(&rx, rgb_to_pair, NULL);
+
+    led_draw(&lm);
+    while (led_getch(&lm) != 'q') {
+        if (led_recv_poll(&rx, 20 /* ms, to check the keyboard */) < 0) {
+            break;
+        }
+    }
+
+    led_recv_end(&rx);
+    led_end(&lm);
+    printf("%llu packets, %llu ignored, %llu frames, %llu torn\n",
+           (unsigned long long)rx.n_packets, (unsigned long long)rx.n_ignored,
+           (unsigned long long)rx.n_frames, (unsigned long long)rx.n_torn);
+    return 0;
+}
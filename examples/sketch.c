@@ -0,0 +1,95 @@
+#include <ncurses.h>
+#include "ledcurses.h"
+#include "ledhistory.h"
+
+#define HISTORY 256
+#define PEN_COLOR 2
+
+// Etch-a-sketch: arrows draw, 'u' undoes a step (as far as HISTORY steps), 'q' quits
+int main(int argc, char *argv[]) {
+    int led_rows, led_cols;
+    if (argc < 3) {
+        led_rows = 12; led_cols = 20;
+    } else {
+        led_rows = atoi(argv[1]); led_cols = atoi(argv[2]);
+    }
+    LEDMatrix lm;
+    if (led_init(&lm, led_rows /* rows of leds */, led_cols /* cols of leds */,
+                      0 /* max terminal rows */, 0 /* terminal cols */,
+                      0 /* window begin row */, 0 /* window begin col */,
+                      0 /* you start ncurses */, 0 /*debug*/)) {
+        fprintf(stderr, "Error starting LEDCurses\n");
+        return 1;
+    }
+    init_pair(PEN_COLOR, COLOR_YELLOW, COLOR_BLACK);
+    keypad(lm.win, TRUE); // <-- Important for the arrows
+
+    // Each snapshot only stores the rows that changed: one or two per step
+    LEDHistory history;
+    if (led_history_init(&history, &lm, HISTORY)) {
+        led_end(&lm);
+        fprintf(stderr, "Couldn't create the history\n");
+        return 1;
+    }
+    // Where the pen was on each snapshot, by ring slot
+    int pen_rows[HISTORY], pen_cols[HISTORY];
+
+    int row = led_rows/2, col = led_cols/2;
+    led_diode_set_value(&lm, row, col, PEN_COLOR);
+    uint64_t id = led_history_take(&history);
+    if (id) {
+        int slot = led_history_slot(&history, id);
+        pen_rows[slot] = row;
+        pen_cols[slot] = col;
+    }
+
+    while (1) {
+        led_draw(&lm);
+
+        int new_row = row, new_col = col;
+        switch (led_getch(&lm)) {
+            case KEY_DOWN:
+                new_row++;
+                break;
+            case KEY_UP:
+                new_row--;
+                break;
+            case KEY_LEFT:
+                new_col--;
+                break;
+            case KEY_RIGHT:
+                new_col++;
+                break;
+            case 'u':
+                id = led_history_rewind(&history, 1);
+                if (id) {
+                    int slot = led_history_slot(&history, id);
+                    row = pen_rows[slot];
+                    col = pen_cols[slot];
+                }
+                continue;
+            case 'q':
+                goto end;
+        }
+        if (new_row < 0 || new_row >= led_rows || new_col < 0 || new_col >= led_cols ||
+            (new_row == row && new_col == col)) {
+            continue;
+        }
+        // The pen leaves a trail
+        led_diode_set_value(&lm, row, col, 1);
+        row = new_row;
+        col = new_col;
+        led_diode_set_value(&lm, row, col, PEN_COLOR);
+
+        id = led_history_take(&history);
+        if (id) {
+            int slot = led_history_slot(&history, id);
+            pen_rows[slot] = row;
+            pen_cols[slot] = col;
+        }
+    }
+end:
+    led_history_end(&history);
+    led_end(&lm);
+    return 0;
+}
@@ -2,6 +2,10 @@
 #include <stdlib.h>  // rand/srand
 #include <time.h>    // time
 #include "ledcurses.h"
+#include "ledgrid.h"
+#include "ledsim.h"
+#include "ledtrace.h"
+#include "ledsprite.h"
 
 #define OFF_COLOR 0
 #define SNAKE_COLOR 1
@@ -9,6 +13,9 @@
 
 #define TICK 8 // ms
 
+static const uint8_t target_pixels[] = {TARGET_COLOR};
+static const LEDSprite target_sprite = {1, 1, target_pixels, NULL, 0};
+
 void show_info(WINDOW *win, const char *fmt, ...) {
     va_list args;
     va_start(args, fmt);
@@ -56,40 +63,18 @@ void draw_snake(LEDMatrix *lm, int *snake_rows, int *snake_cols,
     int i=0;
     while (snake_length--) {
         int arr_index = (arr_size+head_index-i)%arr_size;
-        led_diode_set_value(lm, snake_rows[arr_index], snake_cols[arr_index], color);
+        led_diode_set_value_fast(lm, snake_rows[arr_index], snake_cols[arr_index], color);
         i++;
     }
 }
 
-int collision_with_snake(int *snake_rows, int *snake_cols,
-                         int snake_length, int arr_size, int head_index,
-                         int row, int col) {
-    /* SKIPS THE FIRST ELEMENT !!! */
-    int i=1;
-    while (snake_length--) {
-        int arr_index = (arr_size+head_index-i)%arr_size;
-        if (row == snake_rows[arr_index] && col == snake_cols[arr_index]) {
-            return 1;
-        }
-        i++;
-    }
-    return 0;
+void position_target(LEDGrid *grid, int *tgt_row, int *tgt_col) {
+    // The grid only holds the snake, so any free cell is a valid target
+    led_grid_sample_free(grid, tgt_row, tgt_col);
 }
 
-void position_target(LEDMatrix *lm, int *tgt_row, int *tgt_col,
-                                    int *snake_rows, int *snake_cols,
-                                    int snake_length, int arr_size, int head_index) {
-    // Make sure target and snake don't collide beforehand
-    do {
-        *tgt_row = uniform_prob(lm->led_rows);
-        *tgt_col = uniform_prob(lm->led_cols);
-    } while (collision_with_snake(snake_rows, snake_cols, snake_length, arr_size, head_index,
-                                *tgt_row, *tgt_col) ||
-             (*tgt_row == snake_rows[head_index] && *tgt_col == snake_cols[head_index]));
-}
 
-
-int snake_game(LEDMatrix *lm, WINDOW *info_win) {
+int snake_game(LEDMatrix *lm, LEDGrid *grid, WINDOW *info_win) {
     int cycle = 0; // iterations count
     int ticks_per_update = 50;
     int ticks_this_cycle = 0;
@@ -136,14 +121,16 @@ int snake_game(LEDMatrix *lm, WINDOW *info_win) {
     snake_rows[0] = row;
     snake_cols[0] = col;
     int snake_length = 1;
+    led_grid_reset(grid);
+    led_grid_set(grid, row, col);
     led_diode_set_value(lm, row, col, SNAKE_COLOR);
 
     // Target position
     int tgt_row, tgt_col;
     show_info(info_win, "Allocating target... ");
-    position_target(lm, &tgt_row, &tgt_col, snake_rows, snake_cols, snake_length, arr_size, head_index);
+    position_target(grid, &tgt_row, &tgt_col);
     show_info(info_win, "New target: (%d, %d)\n", tgt_row, tgt_col);
-    led_diode_set_value(lm, tgt_row, tgt_col, TARGET_COLOR);
+    led_blit_sprite(lm, &target_sprite, tgt_row, tgt_col);
 
     int new_dir = dir; // The direction we're told to turn to after a keypress.
 
@@ -168,16 +155,20 @@ int snake_game(LEDMatrix *lm, WINDOW *info_win) {
                 new_dir = DIR_RIGHT;
                 break;
             case 'q':
+                free(snake_rows);
+                free(snake_cols);
                 return GAME_END;
             case 'r':
                 led_diode_unset_attrs(lm, row, col, A_REVERSE);
                 draw_snake(lm, snake_rows, snake_cols, snake_length, arr_size, head_index, OFF_COLOR);
                 led_diode_set_value(lm, tgt_row, tgt_col, OFF_COLOR);
                 snake_length = 0;
+                free(snake_rows);
+                free(snake_cols);
                 return GAME_RESTART;
         }
 
-        napms(TICK);
+        led_napms(lm, TICK);
 
         if (running) {
             ticks_this_cycle++;
@@ -200,7 +191,7 @@ int snake_game(LEDMatrix *lm, WINDOW *info_win) {
 
             if (row == tgt_row && col == tgt_col) {
                 // Collission with target
-                if (snake_length >= (arr_size-1)) {
+                if (led_grid_count_free(grid) == 0) {
                     // If cannot position next target, gotta quit before getting into an endless loop.
                     show_info(info_win, "Full grid. Congrats!\n");
                     running = 0;
@@ -208,21 +199,40 @@ int snake_game(LEDMatrix *lm, WINDOW *info_win) {
                 }
                 // Relocate target
                 show_info(info_win, "Allocating target... ");
-                position_target(lm, &tgt_row, &tgt_col, snake_rows, snake_cols, snake_length, arr_size, head_index);
+                position_target(grid, &tgt_row, &tgt_col);
                 show_info(info_win, "New target: (%d, %d)\n", tgt_row, tgt_col);
 
-                led_diode_set_value(lm, tgt_row, tgt_col, TARGET_COLOR);
+                led_blit_sprite(lm, &target_sprite, tgt_row, tgt_col);
                 led_draw(lm);
                 can_grow = 1;
             } else {
                 can_grow = 0;
             }
 
-            if ((row == 0 && dir == DIR_UP) ||
-                (row == lm->led_rows-1 && dir == DIR_DOWN) ||
-                (col == 0 && dir == DIR_LEFT) ||
-                (col == lm->led_cols-1 && dir == DIR_RIGHT) ||
-                collision_with_snake(snake_rows, snake_cols, snake_length, arr_size, head_index, row, col)) {
+            // Where the head is going to be
+            int next_row = row, next_col = col;
+            switch (dir) {
+                case DIR_UP:
+                    next_row--;
+                    break;
+                case DIR_DOWN:
+                    next_row++;
+                    break;
+                case DIR_LEFT:
+                    next_col--;
+                    break;
+                case DIR_RIGHT:
+                    next_col++;
+                    break;
+            }
+            // The tail moves out of the way unless we grow, so it doesn't count
+            int tail_index = (arr_size+head_index-snake_length+1)%arr_size;
+            int into_tail = !can_grow && next_row == snake_rows[tail_index] &&
+                                         next_col == snake_cols[tail_index];
+
+            if (next_row < 0 || next_row >= lm->led_rows ||
+                next_col < 0 || next_col >= lm->led_cols ||
+                (led_grid_test(grid, next_row, next_col) && !into_tail)) {
                 // Collission with self or with border: Game over.
                 led_diode_set_attrs(lm, row, col, A_REVERSE);
                 running = 0;
@@ -230,36 +240,25 @@ int snake_game(LEDMatrix *lm, WINDOW *info_win) {
                 // No collision: will move.
                 // Turn off tail if we didn't grow
                 if (!can_grow) {
-                    int tail_index = (arr_size+head_index-snake_length+1)%arr_size;
+                    led_grid_clear(grid, snake_rows[tail_index], snake_cols[tail_index]);
                     led_diode_set_value(lm, snake_rows[tail_index], snake_cols[tail_index], OFF_COLOR);
                 } else {
                     snake_length++;
                 }
                 // Now update the keypress
                 //show_info(info_win, "%d - Going %s\n", cycle, dir==DIR_UP? "Up" : (dir==DIR_DOWN? "Down" : (dir==DIR_LEFT? "Left": "Right")));
-                switch (dir) {
-                    case DIR_UP:
-                        row--;
-                        break;
-                    case DIR_DOWN:
-                        row++;
-                        break;
-                    case DIR_LEFT:
-                        col--;
-                        break;
-                    case DIR_RIGHT:
-                        col++;
-                        break;
-                }
+                row = next_row;
+                col = next_col;
                 head_index = (head_index+1) % arr_size;
                 snake_rows[head_index] = row;
                 snake_cols[head_index] = col;
+                led_grid_set(grid, row, col);
+                led_diode_set_value(lm, row, col, SNAKE_COLOR);
             }
             //print_cells(info_win, snake_rows, snake_cols, snake_length, arr_size, head_index);
 
             cycle++;
         }
-        draw_snake(lm, snake_rows, snake_cols, snake_length, arr_size, head_index, SNAKE_COLOR);
     }
 
 }
@@ -282,40 +281,97 @@ int main(int argc, char *argv[]) {
         led_rows = 6; led_cols = 8;
     }
 
+    // And then, a file to write a latency trace to
+    const char *trace_path = argc > 4 ? argv[4] : NULL;
+
     int info_rows = 5;
     int win_rows = -info_rows; // Negative X means "full size minus X"
 
+    // Simulation mode: LEDCURSES_SIM holds a key script (see ledsim.h), and the game
+    // runs headless on a virtual clock, printing a hash per frame when it's over
+    const char *sim_script = getenv("LEDCURSES_SIM");
+    LEDSim sim;
+    WINDOW *info_win = NULL;
     LEDMatrix lm;
-    int err = led_init(&lm, led_rows /* rows of leds */, led_cols /* cols of leds */,
-                            win_rows /* terminal rows */, 100 /* terminal cols */,
-                            0 /* window begin row */, 0 /* window begin col */,
-                            0 /* you start ncurses */, 0 /*debug*/);
-
-    if (err) {
-        fprintf(stderr, "\nError starting LEDCurses\n");
-        fprintf(stderr, "Lines: %d\nwin_rows: %d\ninfo_rows: %d\n", LINES, win_rows, info_rows);
-        return 1;
+    if (sim_script) {
+        if (led_sim_init(&sim, 1 << 20) || led_sim_parse_script(&sim, sim_script) ||
+            led_init_headless(&lm, led_rows, led_cols, led_rows*3, led_cols*6, NULL, 0)) {
+            fprintf(stderr, "Error starting the simulation\n");
+            return 1;
+        }
+        sim.quit_key = 'q';
+        led_sim_attach(&lm, &sim);
+    } else {
+        int err = led_init(&lm, led_rows /* rows of leds */, led_cols /* cols of leds */,
+                                win_rows /* terminal rows */, 100 /* terminal cols */,
+                                0 /* window begin row */, 0 /* window begin col */,
+                                0 /* you start ncurses */, 0 /*debug*/);
+
+        if (err) {
+            fprintf(stderr, "\nError starting LEDCurses\n");
+            fprintf(stderr, "Lines: %d\nwin_rows: %d\ninfo_rows: %d\n", LINES, win_rows, info_rows);
+            return 1;
+        }
+        win_rows = lm.win_rows;
+
+        // Information window at the bottom
+        info_win = newwin(info_rows, 0, win_rows, 0);
+        if (!info_win) {
+            fprintf(stderr, "Couldn't create info window\n");
+            fprintf(stderr, "Lines: %d\nwin_rows: %d\ninfo_rows: %d\n", LINES, win_rows, info_rows);
+            return 1;
+        }
+        scrollok(info_win, 1);
+
+        // By default, color #1 is red
+        init_pair(TARGET_COLOR, COLOR_YELLOW, COLOR_BLACK);
+
+        keypad(lm.win, TRUE); // <-- Important for the arrows
+        nodelay(lm.win, TRUE); // <-- Important for time to run
+        curs_set(0);  // <-- Important because otherwise it's annoying
     }
-    win_rows = lm.win_rows;
 
-    // Information window at the bottom
-    WINDOW *info_win = newwin(info_rows, 0, win_rows, 0);
-    if (!info_win) {
-        fprintf(stderr, "Couldn't create info window\n");
-        fprintf(stderr, "Lines: %d\nwin_rows: %d\ninfo_rows: %d\n", LINES, win_rows, info_rows);
+    // Cells taken by the snake
+    LEDGrid grid;
+    if (led_grid_init(&grid, &lm)) {
+        led_end(&lm);
+        fprintf(stderr, "Couldn't create the snake grid\n");
         return 1;
     }
-    scrollok(info_win, 1);
 
-    // By default, color #1 is red
-    init_pair(TARGET_COLOR, COLOR_YELLOW, COLOR_BLACK);
-
-    keypad(lm.win, TRUE); // <-- Important for the arrows
-    nodelay(lm.win, TRUE); // <-- Important for time to run
-    curs_set(0);  // <-- Important because otherwise it's annoying
+    LEDTrace trace;
+    if (trace_path) {
+        if (led_trace_init(&trace, 1 << 16)) {
+            led_end(&lm);
+            fprintf(stderr, "Couldn't allocate the trace buffer\n");
+            return 1;
+        }
+        led_trace_attach(&lm, &trace);
+    }
 
-    while (snake_game(&lm, info_win) == GAME_RESTART);
+    while (snake_game(&lm, &grid, info_win) == GAME_RESTART);
 
+    led_grid_end(&grid);
     led_end(&lm);
+
+    if (sim_script) {
+        led_sim_write_hashes(&sim, stdout);
+        led_sim_end(&sim);
+    }
+
+    if (trace_path) {
+        FILE *trace_file = fopen(trace_path, "w");
+        if (!trace_file || led_trace_export_json(&trace, trace_file)) {
+            fprintf(stderr, "Couldn't write the trace to %s\n", trace_path);
+        }
+        if (trace_file) {
+            fclose(trace_file);
+        }
+        printf("Input-to-photon latency: p50 %.3f ms, p99 %.3f ms, max %.3f ms\n",
+               led_trace_latency_percentile(&trace, 50)/1e6,
+               led_trace_latency_percentile(&trace, 99)/1e6,
+               trace.latency_max_ns/1e6);
+        led_trace_end(&trace);
+    }
     return 0;
 }
@@ -0,0 +1,72 @@
+#include <ncurses.h>
+#include "ledcurses.h"
+#include "ledtiles.h"
+
+// A 2x2 wall of panels, each mounted differently, showing one 8x12 framebuffer
+#define LED_ROWS 8
+#define LED_COLS 12
+
+int main() {
+    int transforms[4] = {LED_TILE_ROT_0, LED_TILE_ROT_180,
+                         LED_TILE_MIRROR, LED_TILE_ROT_90};
+    LEDMatrix panels[4];
+    LEDTiledDisplay wall;
+    if (led_tiles_init(&wall, LED_ROWS, LED_COLS, 4)) {
+        fprintf(stderr, "Couldn't create the tiled display\n");
+        return 1;
+    }
+
+    for (int t=0; t<4; t++) {
+        int tile_row = (t/2)*LED_ROWS/2;
+        int tile_col = (t%2)*LED_COLS/2;
+        // Quarter turns swap the panel's rows and cols
+        int quarter_turn = transforms[t] == LED_TILE_ROT_90;
+        int panel_rows = quarter_turn ? LED_COLS/2 : LED_ROWS/2;
+        int panel_cols = quarter_turn ? LED_ROWS/2 : LED_COLS/2;
+        int err = led_init(&panels[t], panel_rows, panel_cols,
+                           24 /* terminal rows */, 48 /* terminal cols */,
+                           (t/2)*24 /* window begin row */, (t%2)*48 /* window begin col */,
+                           t > 0 /* the first panel starts ncurses */, 0 /*debug*/);
+        if (err || led_tiles_add(&wall, &panels[t], NULL, tile_row, tile_col, transforms[t]) < 0) {
+            for (int p=0; p<=t; p++) {
+                led_end(&panels[p]);
+            }
+            fprintf(stderr, "Couldn't create panel %d\n", t);
+            return 1;
+        }
+    }
+    keypad(panels[0].win, TRUE); // <-- Important for the arrows
+
+    int row = 1, col = 1;
+    while (1) {
+        led_tiles_set_value(&wall, row, col, 1);
+        led_tiles_draw(&wall);
+
+        // Only the panels showing the old and new positions are redrawn
+        led_tiles_set_value(&wall, row, col, 0);
+        switch (led_getch(&panels[0])) {
+            case KEY_DOWN:
+                row++;
+                break;
+            case KEY_UP:
+                row--;
+                break;
+            case KEY_LEFT:
+                col--;
+                break;
+            case KEY_RIGHT:
+                col++;
+                break;
+            case '\n':
+                goto end;
+        }
+        row = row < 0 ? 0 : (row >= LED_ROWS ? LED_ROWS-1 : row);
+        col = col < 0 ? 0 : (col >= LED_COLS ? LED_COLS-1 : col);
+    }
+end:
+    led_tiles_end(&wall);
+    for (int t=3; t>=0; t--) {
+        led_end(&panels[t]);
+    }
+    return 0;
+}
@@ -1,6 +1,14 @@
 #include <ncurses.h>
 #include "ledcurses.h"
+#include "ledpalette.h"
 
+static void set_diodes(LEDMatrix *lm, int round) {
+    for (int i=0; i<15; i++) {
+        int row = i/5;
+        int col = i%5;
+        led_diode_set_value_fast(lm, row, col, (round+i)%3 + 1 /* 1, 2 or 3 */);
+    }
+}
 
 int main() {
     LEDMatrix lm;
@@ -9,25 +17,41 @@ int main() {
                   0 /* window begin row */, 0 /* window begin col */,
                   0 /* you start ncurses */, 1 /*debug*/);
 
-    init_pair(2, COLOR_GREEN, COLOR_BLACK);
-    init_pair(3, COLOR_BLUE, COLOR_BLACK);
+    // Pairs 1, 2 and 3 cycle through red, green and blue.
+    // Without colors there's no palette: we rotate the diodes' values instead.
+    LEDPalette palette;
+    int use_palette = !led_palette_init(&palette, 1, 3);
+    if (use_palette) {
+        led_palette_set(&palette, 0, COLOR_RED, COLOR_BLACK);
+        led_palette_set(&palette, 1, COLOR_GREEN, COLOR_BLACK);
+        led_palette_set(&palette, 2, COLOR_BLUE, COLOR_BLACK);
+        led_palette_apply(&palette);
+    }
 
-    char round = 0;
-    while (1) {
-        for (int i=0; i<15; i++) {
-            int row = i/5;
-            int col = i%5;
-            led_diode_set_value(&lm, row, col, (round+i)%3 + 1 /* 1, 2 or 3 */);
-        }
-        round++;
-        led_draw(&lm);
+    // With the palette, the diodes never change, only what their colors mean
+    int round = 0;
+    set_diodes(&lm, round);
+    led_draw(&lm);
 
+    while (1) {
         info(&lm, "Any key to continue. PRESS SPACE BAR TO EXIT\n");
         if (led_getch(&lm) == ' ') {
             break;
         }
+
+        if (use_palette) {
+            led_palette_rotate(&palette, 1);
+            led_palette_apply(&palette);
+        } else {
+            round = (round + 1) % 3;
+            set_diodes(&lm, round);
+            led_draw(&lm);
+        }
     }
 
+    if (use_palette) {
+        led_palette_end(&palette);
+    }
     led_end(&lm);
     return 0;
 }
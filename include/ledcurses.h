@@ -21,6 +21,7 @@
 #include <ncurses.h>
 #include <stdlib.h> // calloc
 #include <stdarg.h>
+#include <stdint.h>
 
 #define BIT_FIELD(name) unsigned int name : 1
 #define SQUARE(x) ({ __typeof__(x) _x = x; _x*_x; })
@@ -31,13 +32,27 @@ typedef struct single_led {
     int ch_attrs;
 } Diode;
 
+struct led_raster_pool;
+struct led_trace;
+struct led_sim;
+struct led_presenter;
+struct led_quality;
+
+void led_trace_mutation(struct led_trace *trace); // see ledtrace.h
+
 typedef struct led_matrix {
     WINDOW *win;
     WINDOW *dbgwin;
-    Diode *matrix;
+    void *mem;         // block holding matrix (or the mono bits), circle_mask, cells, cells_shown and the row flags
+    Diode *matrix;     // NULL on matrices from led_init_mono
+    uint64_t *mono_bits; // led_init_mono: a bit per LED (see ledmono.h), NULL otherwise
+    uint64_t *mono_shown; // mono_bits as last rasterized into cells (as last published, with an LEDPresenter)
+    int mono_words;    // 64-bit words per LED row in mono_bits and mono_shown
+    int mono_value;    // diode value the lit LEDs of mono_bits are drawn with
     int led_rows;
     int led_cols;
     int led_size;
+    int max_led_size; // the one fitting the window, led_size can only be smaller
     int char_ratio; // ratio of height to width pixels of a char (cols per row)
     int led_size_ratioed; // led_size*char_ratio, we use it a lot
     int led_halfsize_sq;    // SQUARE(led_size/2)
@@ -48,10 +63,22 @@ typedef struct led_matrix {
     chtype ch_edge_off;
     chtype ch_inner_on;
     chtype ch_inner_off;
+    unsigned char *circle_mask; // per quadrant cell: 0 outside, 1 edge, 2 inner
+    chtype *cells;              // what each window cell should contain
+    chtype *cells_shown;        // what we last wrote to the window
+    unsigned char *dirty_rows;  // LED rows changed since the last led_draw
+    unsigned char *changed_rows; // LED rows changed since the last snapshot (ledhistory.h)
+    struct led_raster_pool *raster_pool;
+    struct led_trace *trace;    // see ledtrace.h, NULL when not tracing
+    struct led_sim *sim;        // see ledsim.h, NULL when on real time and input
+    struct led_presenter *presenter; // see ledpresent.h, NULL when drawing synchronously
+    struct led_quality *quality;     // see ledquality.h, NULL when always at full quality
     BIT_FIELD(i_started_curses);
+    BIT_FIELD(owns_mem);
     BIT_FIELD(uses_color);
     BIT_FIELD(grid_available);
     BIT_FIELD(grid_enabled);
+    BIT_FIELD(mono_redraw);     // cells were blanked: mono_shown is no use until the next led_draw
 } LEDMatrix;
 
 
@@ -60,19 +87,124 @@ void info(LEDMatrix *lm, const char *fmt, ...);
 int led_init(LEDMatrix *lm, int led_rows, int led_cols,
                             int rows, int cols,
                             int begin_row, int begin_col, int curses_started, int debug);
+/* led_mem_size: bytes led_init_mem needs for a matrix of led_rows x led_cols
+ *               on a window of win_rows x win_cols cells (the final sizes:
+ *               no 0 or negative values, and without the debug lines).
+ *      Sizing for a bigger window than the real one is fine.
+ * */
+size_t led_mem_size(int led_rows, int led_cols, int win_rows, int win_cols);
+/* led_init_mem: like led_init, but the matrix and all the internal buffers
+ *               live in `mem` (at least `mem_size` bytes, 16-byte aligned),
+ *               which the caller owns and must keep alive until led_end.
+ *      Nothing else is allocated by the library afterwards, except by ncurses
+ *      itself (windows) and by led_set_raster_threads.
+ *      If `mem` is NULL, it behaves like led_init.
+ *      On failure, the windows are deleted and curses is ended if it started it.
+ * returns 1 on failure, 0 on success.
+ * */
+int led_init_mem(LEDMatrix *lm, int led_rows, int led_cols,
+                                int rows, int cols,
+                                int begin_row, int begin_col, int curses_started, int debug,
+                                void *mem, size_t mem_size);
+/* led_mono_mem_size: like led_mem_size, for led_init_mono and led_init_mono_headless.
+ * */
+size_t led_mono_mem_size(int led_rows, int led_cols, int win_rows, int win_cols);
+/* led_init_mono: like led_init_mem, for single color matrices: each LED is
+ *                a bit of lm->mono_bits instead of a Diode (lm->matrix is
+ *                NULL), drawn like a diode of value `on_value` (not 0) when set.
+ *      Use it through ledmono.h. led_diode_set_value works too (any non 0
+ *      value lights the LED), but attributes, the _fast accessors and the
+ *      helpers writing Diodes (ledfx, ledprim, ledsprite, ...) don't.
+ * returns 1 on failure, 0 on success.
+ * */
+int led_init_mono(LEDMatrix *lm, int led_rows, int led_cols,
+                                 int rows, int cols,
+                                 int begin_row, int begin_col, int curses_started, int debug,
+                                 int on_value, void *mem, size_t mem_size);
+/* led_init_mono_headless: led_init_headless for single color matrices.
+ * returns 1 on failure, 0 on success.
+ * */
+int led_init_mono_headless(LEDMatrix *lm, int led_rows, int led_cols, int rows, int cols,
+                                          int on_value, void *mem, size_t mem_size);
+/* led_init_headless: a matrix without terminal: led_draw only rasterizes into
+ *                    lm->cells, as if on a window of rows x cols cells (both
+ *                    must be positive). ncurses is never called, colors are
+ *                    assumed. `mem` works like in led_init_mem, and may be NULL.
+ *      Attach an LEDSim (ledsim.h) to feed led_getch.
+ * returns 1 on failure, 0 on success.
+ * */
+int led_init_headless(LEDMatrix *lm, int led_rows, int led_cols, int rows, int cols,
+                                     void *mem, size_t mem_size);
 /* led_set_grid: if `value` is not 0, will try to enable the grid,
  *               otherwise, disables the grid
  * returns 1 on failure, 0 on success.
  * */
 int led_set_grid(LEDMatrix *lm, int value);
+/* led_set_led_size: draws the LEDs with a size of `led_size` cell rows,
+ *                   from 1 to lm->max_led_size (the size led_init chose).
+ *      The whole matrix is drawn again on the next led_draw.
+ * returns 1 on failure, 0 on success.
+ * */
+int led_set_led_size(LEDMatrix *lm, int led_size);
 /* led_get_diode: returns a pointer to the Diode at the given (row, col).
- *                If out of bounds, will return NULL.
+ *                If out of bounds (or on a led_init_mono matrix), will return NULL.
  * */
 Diode *led_get_diode(LEDMatrix *lm, int row, int col);
+/* led_diode_at: unchecked version of led_get_diode, inlined in the caller.
+ *               When LEDCURSES_DEBUG is defined (`make debug`), it goes
+ *               through led_get_diode and returns NULL if out of bounds.
+ * */
+static inline Diode *led_diode_at(LEDMatrix *lm, int row, int col) {
+#ifdef LEDCURSES_DEBUG
+    return led_get_diode(lm, row, col);
+#else
+    return &(lm->matrix[row*lm->led_cols + col]);
+#endif
+}
+/* led_diode_set_value_fast, led_diode_set_attrs_fast, led_diode_unset_attrs_fast:
+ *      same as their non-_fast counterparts, but inlined and without bounds
+ *      checks (unless LEDCURSES_DEBUG is defined). Meant for tight update loops.
+ *      Not for led_init_mono matrices.
+ * */
+static inline void led_diode_set_value_fast(LEDMatrix *lm, int row, int col, int value) {
+    Diode *diode = led_diode_at(lm, row, col);
+#ifdef LEDCURSES_DEBUG
+    if (!diode) return;
+#endif
+    diode->value = value;
+    lm->dirty_rows[row] = 1;
+    lm->changed_rows[row] = 1;
+    if (lm->trace) led_trace_mutation(lm->trace);
+}
+static inline void led_diode_set_attrs_fast(LEDMatrix *lm, int row, int col, int attrs) {
+    Diode *diode = led_diode_at(lm, row, col);
+#ifdef LEDCURSES_DEBUG
+    if (!diode) return;
+#endif
+    diode->ch_attrs |= attrs;
+    lm->dirty_rows[row] = 1;
+    lm->changed_rows[row] = 1;
+    if (lm->trace) led_trace_mutation(lm->trace);
+}
+static inline void led_diode_unset_attrs_fast(LEDMatrix *lm, int row, int col, int attrs) {
+    Diode *diode = led_diode_at(lm, row, col);
+#ifdef LEDCURSES_DEBUG
+    if (!diode) return;
+#endif
+    diode->ch_attrs &= ~attrs;
+    lm->dirty_rows[row] = 1;
+    lm->changed_rows[row] = 1;
+    if (lm->trace) led_trace_mutation(lm->trace);
+}
+/* led_mark_dirty: tells led_draw that LED rows [row_begin, row_end) changed.
+ *                 Only needed if you write to lm->matrix yourself.
+ * */
+void led_mark_dirty(LEDMatrix *lm, int row_begin, int row_end);
 /* led_diode_set_value: if `value` is 0, the diode is considered off
  *                      otherwise, diode will be colored with the
  *                      COLOR_PAIR(value).
- *      By default, only COLOR_PAIR(1) is initialized,  but you can
+ *      By default, only COLOR_PAIR(1) is initialized (as red, unless you had
+ *      already defined it), but you can
  *      use whatever value you may have init_pair'd.
  *
  *      Using an uninitialized value is undefined.
@@ -85,16 +217,40 @@ void led_draw_grid(LEDMatrix *lm);
 /* led_draw: draw the LEDMatrix to the window.
  *           call this after each change (for instance,
  *           led_diode_set_value calls)
+ *      Only the LED rows changed since the last call are rasterized into
+ *      lm->cells, and only the cells that changed are written to the window.
+ *      With an LEDPresenter started, it only publishes the frame (ledpresent.h),
+ *      and an LEDQuality may skip it (ledquality.h).
  * */
 void led_draw(LEDMatrix *lm);
+/* led_raster_rows: computes the cells of the dirty LED rows in [row_begin, row_end)
+ *                  into lm->cells. Doesn't call ncurses, so different row
+ *                  ranges can be rasterized from different threads.
+ *      On led_init_mono matrices, only the LEDs whose bit differs from
+ *      lm->mono_shown are rasterized.
+ * */
+void led_raster_rows(LEDMatrix *lm, int row_begin, int row_end);
+/* led_set_raster_threads: rasterize with `n_threads` threads (the caller
+ *                         included) on large matrices. 1 means no threads.
+ * returns 1 on failure, 0 on success.
+ * */
+int led_set_raster_threads(LEDMatrix *lm, int n_threads);
 int led_get_row_center_pos(LEDMatrix *lm, int led_row);
 int led_get_col_center_pos(LEDMatrix *lm, int led_col);
 void led_draw_diode(LEDMatrix *lm, int led_row, int led_col);
 /* led_getch: the getch for this window
+ *            (or the next scripted key, if an LEDSim is attached)
+ *      With an LEDQuality, draws the frame it skipped first.
  * */
 int led_getch(LEDMatrix *lm);
+/* led_napms: napms, or advancing the virtual clock if an LEDSim is attached
+ *      With an LEDQuality, draws the frame it skipped during the nap.
+ * */
+int led_napms(LEDMatrix *lm, int ms);
 /* led_end: destructor for the LEDMatrix.
  *          Be sure to call it at the end to prevent memory leaks.
+ *          It deletes the LED and debug windows, and ends curses if led_init started it.
+ *          Memory given to led_init_mem is not touched.
  * */
 int led_end(LEDMatrix *lm);
 
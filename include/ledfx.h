@@ -0,0 +1,83 @@
+#ifndef LEDFX_H
+#define LEDFX_H
+
+/*
+ * This file is part of LEDCurses.
+ *
+ * LEDCurses is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LEDCurses is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LEDCurses.  If not, see <https://www.gnu.org/licenses/>.
+ * */
+
+#include <stdint.h>
+#include "ledcurses.h"
+
+/* Procedural effects.
+ *
+ *      Effects work on 8-bit intensities and fixed-point phases: a full turn
+ *      of the sine table is 256 steps, and so is fx->t. A kernel fills one
+ *      whole row of intensities at a time (plain loops over uint8_t arrays,
+ *      so the compiler can vectorize them), which are then mapped through a
+ *      256-entry palette into diode values, straight into lm->matrix.
+ *      Only rows whose values changed are marked dirty.
+ * */
+
+struct led_fx;
+
+typedef struct led_fx_kernel {
+    /* Called once per frame before the rows, may be NULL */
+    void (*begin_frame)(struct led_fx *fx);
+    /* Fills out[0..led_cols) with the intensities of LED row `row` */
+    void (*row)(const struct led_fx *fx, int row, uint8_t *out);
+} LEDFxKernel;
+
+typedef struct led_fx {
+    LEDMatrix *lm;
+    uint32_t t;         // time, in 1/256ths of a turn of the sine table
+    uint32_t speed;     // added to t after each frame
+    uint32_t seed;      // for the noise and fire effects
+    int palette[256];   // intensity -> diode value
+    uint8_t *row_buf;   // led_cols intensities
+    uint8_t *state;     // led_rows x led_cols bytes for effects with memory (fire)
+    void *user;         // for custom kernels
+} LEDFx;
+
+extern const LEDFxKernel led_fx_plasma;
+extern const LEDFxKernel led_fx_fire;
+extern const LEDFxKernel led_fx_noise;
+extern const LEDFxKernel led_fx_gradient;
+
+/* led_fx_init: effects for `lm`. The palette starts as off below half
+ *              intensity, COLOR_PAIR(1) above.
+ * returns 1 on failure, 0 on success.
+ * */
+int led_fx_init(LEDFx *fx, LEDMatrix *lm);
+/* led_fx_set_palette: splits the intensities in `n` (at least 1) equal bands,
+ *                     the i-th one showing values[i].
+ * returns 1 on failure (the palette is left as it was), 0 on success.
+ * */
+int led_fx_set_palette(LEDFx *fx, const int *values, int n);
+/* led_fx_sin8: 128 + 127*sin(phase*2pi/256)
+ * */
+uint8_t led_fx_sin8(uint8_t phase);
+/* led_fx_hash8: pseudo random byte for lattice point (x, y, z)
+ * */
+uint8_t led_fx_hash8(uint32_t seed, int x, int y, int z);
+/* led_fx_render: renders one frame of `kernel` into the matrix and advances
+ *                fx->t. Call led_draw afterwards.
+ * */
+void led_fx_render(LEDFx *fx, const LEDFxKernel *kernel);
+/* led_fx_end: destructor for the LEDFx.
+ * */
+void led_fx_end(LEDFx *fx);
+
+#endif // LEDFX_H
@@ -0,0 +1,63 @@
+#ifndef LEDGRID_H
+#define LEDGRID_H
+
+/*
+ * This file is part of LEDCurses.
+ *
+ * LEDCurses is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LEDCurses is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LEDCurses.  If not, see <https://www.gnu.org/licenses/>.
+ * */
+
+#include <stdint.h>
+#include "ledcurses.h"
+
+/* LEDGrid: occupancy bitmap with the same dimensions as an LEDMatrix.
+ *
+ *      Besides the packed bitset (one bit per LED), it keeps the free
+ *      cells in a dense array plus its inverse index, so testing, setting,
+ *      clearing and sampling a random free cell are all O(1).
+ * */
+typedef struct led_grid {
+    uint64_t *bits;
+    int *free_cells; // dense array of free cell indices (row*cols + col)
+    int *free_pos;   // position of each cell in free_cells, -1 if occupied
+    int n_free;
+    int rows;
+    int cols;
+} LEDGrid;
+
+/* led_grid_init: creates an empty (all cells free) grid sized like `lm`.
+ * returns 1 on failure, 0 on success.
+ * */
+int led_grid_init(LEDGrid *grid, LEDMatrix *lm);
+/* led_grid_reset: marks every cell as free again.
+ * */
+void led_grid_reset(LEDGrid *grid);
+/* led_grid_test: returns 1 if (row, col) is occupied, 0 otherwise.
+ *                Out of bounds cells are reported as occupied.
+ * */
+int led_grid_test(LEDGrid *grid, int row, int col);
+void led_grid_set(LEDGrid *grid, int row, int col);
+void led_grid_clear(LEDGrid *grid, int row, int col);
+/* led_grid_count_free: number of free cells.
+ * */
+int led_grid_count_free(LEDGrid *grid);
+/* led_grid_sample_free: stores a uniformly chosen free cell in (*row, *col).
+ * returns 1 if the grid is full, 0 on success.
+ * */
+int led_grid_sample_free(LEDGrid *grid, int *row, int *col);
+/* led_grid_end: destructor for the LEDGrid.
+ * */
+void led_grid_end(LEDGrid *grid);
+
+#endif // LEDGRID_H
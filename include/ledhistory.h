@@ -0,0 +1,87 @@
+#ifndef LEDHISTORY_H
+#define LEDHISTORY_H
+
+/*
+ * This file is part of LEDCurses.
+ *
+ * LEDCurses is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LEDCurses is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LEDCurses.  If not, see <https://www.gnu.org/licenses/>.
+ * */
+
+#include <stdint.h>
+#include "ledcurses.h"
+
+/* A copy of one LED row, shared by every snapshot where the row is the same
+ * */
+typedef struct led_row_block {
+    int refs;
+    struct led_row_block *next_free;
+    Diode diodes[];
+} LEDRowBlock;
+
+typedef struct led_snapshot {
+    uint64_t id;
+    LEDRowBlock **rows;
+} LEDSnapshot;
+
+/* LEDHistory: bounded ring of snapshots of an LEDMatrix.
+ *
+ *      Snapshots are copy-on-write by LED row: taking one only copies the
+ *      rows changed since the previous one (lm->changed_rows, kept by the
+ *      setters and led_mark_dirty), and shares the others. Restoring one
+ *      only copies back the rows that differ from the matrix, and marks
+ *      just those dirty. Once the ring is full, taking a snapshot forgets
+ *      the oldest one.
+ * */
+typedef struct led_history {
+    LEDMatrix *lm;
+    LEDSnapshot *ring;
+    int max_snapshots;
+    int n_snapshots;
+    int oldest;                 // ring index of the oldest snapshot
+    uint64_t next_id;
+    LEDRowBlock **current;      // blocks equal to the matrix rows (unless changed since)
+    LEDRowBlock *free_blocks;   // released blocks, reused before allocating
+    int n_blocks;               // blocks in use, the current ones included
+} LEDHistory;
+
+/* led_history_init: empty history of up to `max_snapshots` snapshots.
+ * returns 1 on failure, 0 on success.
+ * */
+int led_history_init(LEDHistory *history, LEDMatrix *lm, int max_snapshots);
+/* led_history_take: snapshots the diodes of the matrix.
+ * returns the id of the snapshot (ids grow with each one, and are never
+ *         reused), or 0 on failure (no memory).
+ * */
+uint64_t led_history_take(LEDHistory *history);
+/* led_history_slot: ring index (0 to max_snapshots-1) of snapshot `id`,
+ *                   to keep your own data per snapshot in an array of that size.
+ *      Ids can't be used for that: rewinds leave gaps between them.
+ * returns -1 if the snapshot is not in the history anymore.
+ * */
+int led_history_slot(LEDHistory *history, uint64_t id);
+/* led_history_restore: sets the diodes back to snapshot `id`. Call led_draw
+ *                      afterwards, as with any change.
+ * returns 1 if the snapshot is not in the history anymore, 0 on success.
+ * */
+int led_history_restore(LEDHistory *history, uint64_t id);
+/* led_history_rewind: restores the snapshot `steps` before the newest one
+ *                     (0 is the newest) and forgets the ones after it.
+ * returns the id of the restored snapshot, or 0 if there aren't enough.
+ * */
+uint64_t led_history_rewind(LEDHistory *history, int steps);
+/* led_history_end: destructor for the LEDHistory.
+ * */
+void led_history_end(LEDHistory *history);
+
+#endif // LEDHISTORY_H
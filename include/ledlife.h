@@ -0,0 +1,64 @@
+#ifndef LEDLIFE_H
+#define LEDLIFE_H
+
+/*
+ * This file is part of LEDCurses.
+ *
+ * LEDCurses is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LEDCurses is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LEDCurses.  If not, see <https://www.gnu.org/licenses/>.
+ * */
+
+#include <stdint.h>
+#include "ledmono.h"
+
+/* LEDLife: life-like cellular automaton running on an LEDMono framebuffer.
+ *
+ *      Each step works on 64 cells at once: the 8 neighbours of a word are
+ *      shifted words of the rows around it, and their counts are added with
+ *      bitwise full adders into 4 bit planes. The rule then picks, from the
+ *      planes, the cells that are born or survive.
+ *      Any outer totalistic rule works, written as "B3/S23" (Life),
+ *      "B36/S23" (HighLife), "B2/S" (Seeds), ...
+ * */
+typedef struct led_life {
+    LEDMono *mono;
+    uint64_t *next;         // scratch generation, same layout as mono->bits
+    uint16_t birth;         // bit n: a dead cell with n live neighbours is born
+    uint16_t survive;       // bit n: a live cell with n live neighbours survives
+    uint64_t generation;
+    BIT_FIELD(wrap);        // the edges wrap around (torus), dead otherwise
+} LEDLife;
+
+/* led_life_init: runs `rule` on the cells of `mono`, with dead edges.
+ * returns 1 on failure (including invalid rules), 0 on success.
+ * */
+int led_life_init(LEDLife *life, LEDMono *mono, const char *rule);
+/* led_life_set_rule: parses a "B.../S..." rule.
+ * returns 1 if it's invalid (the rule is left as it was), 0 on success.
+ * */
+int led_life_set_rule(LEDLife *life, const char *rule);
+/* led_life_randomize: each cell is alive with `percent` % probability (rand()).
+ * */
+void led_life_randomize(LEDLife *life, int percent);
+/* led_life_step: computes the next generation into mono->bits.
+ *                Draw it with led_mono_draw.
+ * */
+void led_life_step(LEDLife *life);
+/* led_life_population: number of live cells.
+ * */
+int led_life_population(LEDLife *life);
+/* led_life_end: destructor for the LEDLife. The LEDMono is not ended.
+ * */
+void led_life_end(LEDLife *life);
+
+#endif // LEDLIFE_H
@@ -0,0 +1,96 @@
+#ifndef LEDMONO_H
+#define LEDMONO_H
+
+/*
+ * This file is part of LEDCurses.
+ *
+ * LEDCurses is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LEDCurses is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LEDCurses.  If not, see <https://www.gnu.org/licenses/>.
+ * */
+
+#include <stdint.h>
+#include "ledcurses.h"
+
+/* LEDMono: 1-bit-per-LED framebuffer for single color panels.
+ *
+ *      It works on a matrix from led_init_mono, which has no Diodes: the
+ *      bits are the matrix, and led_draw rasterizes from them. Each LED row
+ *      is packed into words_per_row 64-bit words (bit j%64 of word j/64 is
+ *      column j; bits past the last column stay 0). The matrix also keeps
+ *      the bits it last drew (lm->mono_shown): XOR'ing both tells which LED
+ *      rows changed, and only those are marked dirty, and led_draw only
+ *      rasterizes the LEDs whose bit changed. That's 2 bits per LED,
+ *      instead of the 64 of a Diode.
+ * */
+typedef struct led_mono {
+    LEDMatrix *lm;
+    uint64_t *bits;     // lm->mono_bits
+    uint64_t *shown;    // lm->mono_shown
+    int words_per_row;
+    int rows;
+    int cols;
+} LEDMono;
+
+/* led_mono_init: framebuffer for `lm`, which must come from led_init_mono
+ *                (or led_init_mono_headless). Lit LEDs have the value given there.
+ * returns 1 on failure, 0 on success.
+ * */
+int led_mono_init(LEDMono *mono, LEDMatrix *lm);
+
+/* Unchecked bit accessors (checked if LEDCURSES_DEBUG is defined)
+ * */
+static inline uint64_t *led_mono_word(LEDMono *mono, int row, int col) {
+    return &mono->bits[row*mono->words_per_row + (col >> 6)];
+}
+#ifdef LEDCURSES_DEBUG
+#define LED_MONO_CHECK(mono, row, col, ret) \
+    if ((row) < 0 || (row) >= (mono)->rows || (col) < 0 || (col) >= (mono)->cols) { \
+        err((mono)->lm, "LED position out of grid\n"); \
+        return ret; \
+    }
+#else
+#define LED_MONO_CHECK(mono, row, col, ret)
+#endif
+static inline void led_mono_set(LEDMono *mono, int row, int col) {
+    LED_MONO_CHECK(mono, row, col, )
+    *led_mono_word(mono, row, col) |= (uint64_t)1 << (col & 63);
+}
+static inline void led_mono_clear(LEDMono *mono, int row, int col) {
+    LED_MONO_CHECK(mono, row, col, )
+    *led_mono_word(mono, row, col) &= ~((uint64_t)1 << (col & 63));
+}
+static inline void led_mono_toggle(LEDMono *mono, int row, int col) {
+    LED_MONO_CHECK(mono, row, col, )
+    *led_mono_word(mono, row, col) ^= (uint64_t)1 << (col & 63);
+}
+static inline int led_mono_test(LEDMono *mono, int row, int col) {
+    LED_MONO_CHECK(mono, row, col, 0)
+    return (*led_mono_word(mono, row, col) >> (col & 63)) & 1;
+}
+
+/* led_mono_fill: turns every LED on (on != 0) or off.
+ * */
+void led_mono_fill(LEDMono *mono, int on);
+/* led_mono_changed: how many LEDs differ from the last drawn ones.
+ * */
+int led_mono_changed(LEDMono *mono);
+/* led_mono_draw: marks the LED rows with changes dirty and calls led_draw,
+ *                which redraws just those (or publishes them, with an LEDPresenter).
+ * returns how many LEDs changed.
+ * */
+int led_mono_draw(LEDMono *mono);
+/* led_mono_end: destructor for the LEDMono.
+ * */
+void led_mono_end(LEDMono *mono);
+
+#endif // LEDMONO_H
@@ -0,0 +1,68 @@
+#ifndef LEDPALETTE_H
+#define LEDPALETTE_H
+
+/*
+ * This file is part of LEDCurses.
+ *
+ * LEDCurses is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LEDCurses is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LEDCurses.  If not, see <https://www.gnu.org/licenses/>.
+ * */
+
+#include "ledcurses.h"
+
+/* LEDPalette: animations by redefining color pairs instead of rewriting diodes.
+ *
+ *      A palette owns the color pairs first_pair..first_pair+n_pairs-1, which
+ *      are the diode values you use. Each pair shows one of the palette slots
+ *      (a foreground/background couple): pair first_pair+i shows slot
+ *      (i + offset) % n_pairs, so rotating the palette is just changing offset.
+ *      led_palette_apply only init_pair's the pairs whose colors changed, and
+ *      ncurses then repaints just the cells using them on the next refresh,
+ *      without a single led_draw.
+ * */
+typedef struct led_palette {
+    int first_pair;
+    int n_pairs;
+    int offset;
+    short *slot_fg;     // colors of each slot
+    short *slot_bg;
+    short *shown_fg;    // colors each pair had on the last apply, -2 if never set
+    short *shown_bg;
+} LEDPalette;
+
+/* led_palette_init: takes over pairs first_pair..first_pair+n_pairs-1.
+ *                   All slots start as COLOR_WHITE over COLOR_BLACK.
+ * returns 1 on failure (for instance, not enough color pairs), 0 on success.
+ * */
+int led_palette_init(LEDPalette *palette, int first_pair, int n_pairs);
+/* led_palette_set: defines slot `index`.
+ * */
+void led_palette_set(LEDPalette *palette, int index, short fg, short bg);
+/* led_palette_rotate: shifts which slot each pair shows by `steps` (may be negative).
+ * */
+void led_palette_rotate(LEDPalette *palette, int steps);
+/* led_palette_set_rgb: redefines `color` (0 to 1000 per channel), for
+ *                      fades and pulses. All the slots using it change.
+ * returns 1 if the terminal can't change colors, 0 on success.
+ * */
+int led_palette_set_rgb(short color, short r, short g, short b);
+/* led_palette_apply: init_pair's the pairs that changed since the last call
+ *                    and refreshes the screen.
+ * returns how many pairs were redefined.
+ * */
+int led_palette_apply(LEDPalette *palette);
+/* led_palette_end: destructor for the LEDPalette. Pairs keep their colors.
+ * */
+void led_palette_end(LEDPalette *palette);
+
+#endif // LEDPALETTE_H
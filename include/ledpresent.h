@@ -0,0 +1,87 @@
+#ifndef LEDPRESENT_H
+#define LEDPRESENT_H
+
+/*
+ * This file is part of LEDCurses.
+ *
+ * LEDCurses is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LEDCurses is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LEDCurses.  If not, see <https://www.gnu.org/licenses/>.
+ * */
+
+#include <pthread.h>
+#include <stdint.h>
+#include "ledcurses.h"
+
+#define LED_PRESENT_KEYS    64  // input queue length
+#define LED_PRESENT_POLL_MS 10  // keyboard polling period while idle
+
+typedef struct led_frame {
+    Diode *matrix;              // a copy of lm->matrix,
+    uint64_t *mono_bits;        // or of lm->mono_bits on led_init_mono matrices
+    unsigned char *dirty_rows;  // rows changed since the previous published frame
+} LEDFrame;
+
+/* LEDPresenter: draws an LEDMatrix from its own thread.
+ *
+ *      Once started, led_draw only publishes the frame: it copies the matrix
+ *      into the back buffer and swaps it with the ready one, without waiting
+ *      for the terminal. The presenter thread takes the ready frame as its
+ *      front buffer and draws it, so it always draws the newest frame; the
+ *      frames published in the meantime are dropped (their dirty rows are
+ *      carried over).
+ *      The presenter thread owns ncurses: it also reads the keyboard, and
+ *      led_getch takes the keys from its queue. While it runs, the app
+ *      thread must not call ncurses, nor led_set_grid, led_draw_diode or
+ *      anything else writing to the window (ledpalette included).
+ * */
+typedef struct led_presenter {
+    LEDMatrix *lm;
+    LEDMatrix view;             // lm as the presenter thread draws it (from `front`)
+    void *mem;                  // the three frames (and view.mono_shown)
+    LEDFrame frames[3];
+    int back;                   // indices into frames
+    int ready;
+    int front;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t frame_cv;
+    pthread_cond_t key_cv;
+    int keys[LED_PRESENT_KEYS]; // ring
+    int key_head;
+    int n_keys;
+    uint64_t n_published;       // stats
+    uint64_t n_presented;
+    uint64_t n_dropped;         // published, but replaced before being drawn
+    BIT_FIELD(fresh);           // `ready` wasn't drawn yet
+    BIT_FIELD(quit);
+    BIT_FIELD(blocking);        // led_getch waits for a key (the window wasn't nodelay)
+} LEDPresenter;
+
+/* led_presenter_start: starts drawing `lm` from a new thread.
+ *      Settings of lm (grid, raster threads, ...) must be done before.
+ *      Tracing, simulation and LEDQuality are not supported.
+ * returns 1 on failure, 0 on success.
+ * */
+int led_presenter_start(LEDPresenter *presenter, LEDMatrix *lm);
+/* led_presenter_publish: what led_draw does while the presenter runs.
+ * */
+void led_presenter_publish(LEDPresenter *presenter);
+/* led_presenter_getch: what led_getch does while the presenter runs.
+ * */
+int led_presenter_getch(LEDPresenter *presenter);
+/* led_presenter_stop: draws the last published frame, stops the thread and
+ *                     gives ncurses back to the app thread. led_end calls it.
+ * */
+void led_presenter_stop(LEDPresenter *presenter);
+
+#endif // LEDPRESENT_H
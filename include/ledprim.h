@@ -0,0 +1,58 @@
+#ifndef LEDPRIM_H
+#define LEDPRIM_H
+
+/*
+ * This file is part of LEDCurses.
+ *
+ * LEDCurses is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LEDCurses is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LEDCurses.  If not, see <https://www.gnu.org/licenses/>.
+ * */
+
+#include "ledcurses.h"
+
+/* Drawing primitives.
+ *
+ *      Shapes are rasterized as horizontal spans of diode values, written
+ *      straight into the matrix (attributes are left alone). Everything is
+ *      clipped to the matrix, so coordinates may be out of it, and each
+ *      primitive marks its range of LED rows dirty once, not per diode.
+ *      Mono matrices (led_init_mono) have no diodes: nothing is drawn on them.
+ * */
+
+/* led_hspan: sets the diodes of `row` from col_begin to col_end (both included).
+ * */
+void led_hspan(LEDMatrix *lm, int row, int col_begin, int col_end, int value);
+/* led_line: Bresenham line from (row0, col0) to (row1, col1), both ends included.
+ * */
+void led_line(LEDMatrix *lm, int row0, int col0, int row1, int col1, int value);
+/* led_rect: rows x cols rectangle with its top-left corner at (row, col),
+ *           either filled or just its outline.
+ * */
+void led_rect(LEDMatrix *lm, int row, int col, int rows, int cols, int value, int filled);
+/* led_circle: midpoint circle centered at (row, col), either filled or
+ *             just its outline. Note that LEDs are round, not cells, so
+ *             the circle looks like one regardless of the terminal font.
+ * */
+void led_circle(LEDMatrix *lm, int row, int col, int radius, int value, int filled);
+/* led_polygon: closed polygon through the n vertices (rows[i], cols[i]).
+ *              Filled polygons use the even-odd rule, and include their outline.
+ * returns 1 on failure (no memory), 0 on success.
+ * */
+int led_polygon(LEDMatrix *lm, const int *rows, const int *cols, int n, int value, int filled);
+/* led_flood_fill: sets to `value` the region of diodes 4-connected to
+ *                 (row, col) that have its same value.
+ * returns 1 on failure (no memory, or a mono matrix), 0 on success.
+ * */
+int led_flood_fill(LEDMatrix *lm, int row, int col, int value);
+
+#endif // LEDPRIM_H
@@ -0,0 +1,103 @@
+#ifndef LEDQUALITY_H
+#define LEDQUALITY_H
+
+/*
+ * This file is part of LEDCurses.
+ *
+ * LEDCurses is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LEDCurses is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LEDCurses.  If not, see <https://www.gnu.org/licenses/>.
+ * */
+
+#include <stdint.h>
+#include "ledcurses.h"
+
+#define LED_QUALITY_FULL        0   // as configured
+#define LED_QUALITY_FLAT        1   // edge ring drawn like the inside
+// From level 2 on, each level draws the LEDs 2 cell rows smaller
+
+#define LED_QUALITY_PATIENCE    8   // frames over budget before degrading
+#define LED_QUALITY_RETRY_MS    5   // led_napms retries a skipped frame this often
+
+/* LEDQuality: adapts how much led_draw writes to what the terminal takes.
+ *
+ *      Before each frame, it looks at the output queue of the terminal
+ *      (TIOCOUTQ) and at how fast it drained since the last look. While
+ *      the queued bytes alone would take longer than the budget to go
+ *      out, frames are skipped (their dirty rows wait for the next one).
+ *      A skipped frame is not lost if no other comes: led_napms draws it
+ *      as soon as the terminal takes it, and led_getch before waiting for
+ *      a key (or tries to, if the window is nodelay).
+ *      After each frame, the latency (time to write it plus the queue
+ *      drain time) is compared to the budget: when it stays over, the
+ *      quality goes down one level; when it stays well under, it goes
+ *      back up, waiting longer each time going up didn't last.
+ *      Can't be combined with an LEDPresenter, which drops frames on its own.
+ * */
+typedef struct led_quality {
+    LEDMatrix *lm;
+    int fd;                 // terminal whose output queue is measured (stdout by default)
+    int budget_ms;          // target latency
+    int level;              // LED_QUALITY_*, or smaller sizes
+    int max_level;
+    int full_size;          // led_size and glyphs at full quality
+    chtype full_edge_on;
+    chtype full_edge_off;
+    double drain_rate;      // bytes per ms the terminal takes (0 until measured)
+    double latency_ms;      // smoothed latency of the drawn frames
+    int last_queued;        // output queue at the last sample, -1 if not measurable
+    uint64_t last_sample_ns;
+    uint64_t frame_begin_ns;
+    int queued_before;      // output queue when the current frame began
+    int over;               // consecutive frames over budget
+    int under;              // consecutive frames well under budget
+    int upgrade_after;      // frames under budget needed to go up a level
+    uint64_t last_change;   // frame of the last level change
+    uint64_t n_frames;      // stats
+    uint64_t n_skipped;
+    uint64_t n_bytes;
+    int last_bytes;         // bytes and cells the last drawn frame wrote
+    int last_cells;
+    BIT_FIELD(pending);     // the last frame was skipped
+    BIT_FIELD(force);       // draw even if the terminal is busy
+} LEDQuality;
+
+/* led_quality_init: attaches a controller keeping latency under budget_ms.
+ *                   Glyphs and LED size should be set up before.
+ *                   Fails if an LEDPresenter is running.
+ * returns 1 on failure, 0 on success.
+ * */
+int led_quality_init(LEDQuality *quality, LEDMatrix *lm, int budget_ms);
+/* led_quality_set_level: forces a quality level (clamped to the valid ones).
+ * */
+void led_quality_set_level(LEDQuality *quality, int level);
+/* led_quality_skip: led_draw asks it before each frame.
+ * returns 1 if the frame must be skipped, 0 otherwise.
+ * */
+int led_quality_skip(LEDQuality *quality);
+/* led_quality_frame_done: led_draw tells it how many cells the frame wrote.
+ * */
+void led_quality_frame_done(LEDQuality *quality, int n_cells);
+/* led_quality_flush: draws the skipped frame, if any. Unless `force`, only
+ *                    if the terminal can take it now.
+ * */
+void led_quality_flush(LEDQuality *quality, int force);
+/* led_quality_napms: what led_napms does: naps `ms`, drawing the skipped
+ *                    frame as soon as the terminal can take it.
+ * */
+int led_quality_napms(LEDQuality *quality, int ms);
+/* led_quality_end: draws the skipped frame, if any, and detaches the
+ *                  controller, back to full quality.
+ * */
+void led_quality_end(LEDQuality *quality);
+
+#endif // LEDQUALITY_H
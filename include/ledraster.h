@@ -0,0 +1,39 @@
+#ifndef LEDRASTER_H
+#define LEDRASTER_H
+
+/*
+ * This file is part of LEDCurses.
+ *
+ * LEDCurses is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LEDCurses is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LEDCurses.  If not, see <https://www.gnu.org/licenses/>.
+ * */
+
+#include "ledcurses.h"
+
+/* Below this many LEDs, waking up the workers costs more than it saves */
+#define LED_RASTER_MIN_PARALLEL 4096
+
+/* Worker pool used by led_draw (see led_set_raster_threads).
+ * Each run splits the LED rows into one band per thread, the calling
+ * thread included, and calls led_raster_rows on each band.
+ * */
+typedef struct led_raster_pool LEDRasterPool;
+
+LEDRasterPool *led_raster_pool_init(LEDMatrix *lm, int n_threads);
+/* led_raster_pool_run: rasterizes every dirty row of the matrix,
+ *                      returns once all the bands are done.
+ * */
+void led_raster_pool_run(LEDRasterPool *pool);
+void led_raster_pool_end(LEDRasterPool *pool);
+
+#endif // LEDRASTER_H
@@ -0,0 +1,111 @@
+#ifndef LEDRECV_H
+#define LEDRECV_H
+
+/*
+ * This file is part of LEDCurses.
+ *
+ * LEDCurses is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LEDCurses is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LEDCurses.  If not, see <https://www.gnu.org/licenses/>.
+ * */
+
+#include <stdint.h>
+#include "ledcurses.h"
+
+#define LED_RECV_ARTNET     0   // ArtDmx (0x5000) and ArtSync (0x5200)
+#define LED_RECV_E131       1   // E1.31 data and universe sync packets
+
+#define LED_RECV_ARTNET_PORT    6454
+#define LED_RECV_E131_PORT      5568
+
+#define LED_RECV_BATCH          64      // datagrams per recvmmsg
+#define LED_RECV_PACKET_SIZE    640     // fits the largest E1.31 data packet
+#define LED_RECV_CHANNELS       512     // DMX channels per universe
+
+/* LEDRecvColor: turns the channels of one pixel (1 or 3 of them) into a
+ *               diode value.
+ * */
+typedef int (*LEDRecvColor)(const uint8_t *channels, void *arg);
+
+/* LEDReceiver: software preview of an E1.31 or Art-Net pixel stream.
+ *
+ *      Pixels are laid out serially over the universes first_universe,
+ *      first_universe+1, ... (pixels_per_universe in each, a pixel never
+ *      spans two universes), and pixel i goes to the diode pixel_map[i]
+ *      (row*led_cols + col, -1 to drop it). Datagrams are read in batches
+ *      with recvmmsg, and each universe is decoded straight into the matrix,
+ *      only touching the diodes that changed.
+ *      All the universes make up one sync group: the frame is drawn once all
+ *      of them have arrived. If the sender uses sync packets, the complete
+ *      frame waits for the next one.
+ *      A new sequence number (the same on every universe of a frame) starts
+ *      the next frame; an unfinished one is dropped as torn. Duplicates and
+ *      packets up to 20 sequence numbers late are ignored. Without sequence
+ *      numbers (Art-Net's 0), a universe arriving twice starts the next frame.
+ * */
+typedef struct led_receiver {
+    LEDMatrix *lm;
+    int fd;
+    int protocol;               // LED_RECV_*
+    int first_universe;
+    int n_universes;
+    int channels_per_pixel;
+    int pixels_per_universe;
+    int n_pixels;
+    int *pixel_map;             // pixel index -> diode index, or -1
+    LEDRecvColor color;
+    void *color_arg;
+    uint64_t *arrived;          // bitset of the universes of the current frame
+    int n_arrived;
+    int sequence;               // of the last universe, -1 if it had none
+    uint8_t *packets;           // LED_RECV_BATCH buffers of LED_RECV_PACKET_SIZE
+    uint64_t n_packets;         // stats
+    uint64_t n_ignored;         // malformed, other protocol or unmapped universe
+    uint64_t n_frames;          // frames drawn
+    uint64_t n_torn;            // frames abandoned because the next one started
+    BIT_FIELD(synced);          // the sender uses sync packets
+    BIT_FIELD(complete);        // every universe arrived, waiting for sync
+} LEDReceiver;
+
+/* led_recv_init: listens for `protocol` on addr:port (port 0 picks the
+ *                standard one for the protocol, addr NULL means any).
+ *      The default map is 3 channels per pixel, 170 pixels per universe,
+ *      first universe 0 for Art-Net and 1 for E1.31, pixels in row-major
+ *      order, with
+ *      led_recv_color_mono as color function (see led_recv_set_map).
+ * returns 1 on failure, 0 on success.
+ * */
+int led_recv_init(LEDReceiver *rx, LEDMatrix *lm, int protocol, const char *addr, int port);
+/* led_recv_set_map: `pixel_map` has led_rows*led_cols entries (copied), or
+ *                   is NULL for row-major order. pixels_per_universe 0 means
+ *                   as many as fit (512/channels_per_pixel).
+ * returns 1 on failure, 0 on success.
+ * */
+int led_recv_set_map(LEDReceiver *rx, int first_universe, int channels_per_pixel,
+                                      int pixels_per_universe, const int *pixel_map);
+/* led_recv_set_color: sets the function turning pixels into diode values.
+ * */
+void led_recv_set_color(LEDReceiver *rx, LEDRecvColor color, void *arg);
+/* led_recv_color_mono: value 1 if any channel is at least half lit, 0 otherwise.
+ *                      `arg` points to the channels per pixel (an int).
+ * */
+int led_recv_color_mono(const uint8_t *channels, void *arg);
+/* led_recv_poll: waits up to timeout_ms (-1: forever, 0: not at all) for
+ *                datagrams, then reads all the pending ones.
+ * returns the number of frames drawn, or -1 on error.
+ * */
+int led_recv_poll(LEDReceiver *rx, int timeout_ms);
+/* led_recv_end: destructor for the LEDReceiver. The matrix is not led_end'ed.
+ * */
+void led_recv_end(LEDReceiver *rx);
+
+#endif // LEDRECV_H
@@ -0,0 +1,90 @@
+#ifndef LEDSIM_H
+#define LEDSIM_H
+
+/*
+ * This file is part of LEDCurses.
+ *
+ * LEDCurses is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LEDCurses is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LEDCurses.  If not, see <https://www.gnu.org/licenses/>.
+ * */
+
+#include <stdint.h>
+#include <stdio.h>
+#include "ledcurses.h"
+
+/* LEDSim: deterministic simulation of an LEDMatrix session.
+ *
+ *      Once attached, led_napms advances a virtual clock instead of sleeping,
+ *      led_getch reads keys from a script instead of the terminal, and each
+ *      led_draw hashes the frame (diodes and rasterized cells). Together with
+ *      led_init_headless (no terminal at all), a session runs as fast as the
+ *      CPU allows, and two runs of the same program, seed and script must
+ *      produce the same hashes.
+ * */
+
+typedef struct led_sim_event {
+    uint64_t at_ms;     // virtual time from which led_getch returns it
+    int key;
+} LEDSimEvent;
+
+typedef struct led_sim_frame {
+    uint64_t frame;
+    uint64_t at_ms;
+    uint64_t hash;
+} LEDSimFrame;
+
+typedef struct led_sim {
+    uint64_t now_ms;        // virtual clock
+    LEDSimEvent *script;
+    int n_events;
+    int next_event;
+    int quit_key;           // returned once the script is over (ERR by default)
+    LEDSimFrame *frames;    // ring of the last max_frames frame hashes
+    int max_frames;
+    uint64_t n_frames;
+    uint64_t session_hash;  // hash of all the frame hashes
+    BIT_FIELD(blocking);    // led_getch waits (jumps the clock) for the next key
+} LEDSim;
+
+/* led_sim_init: empty script, clock at 0, room for `max_frames` frame hashes.
+ * returns 1 on failure, 0 on success.
+ * */
+int led_sim_init(LEDSim *sim, int max_frames);
+/* led_sim_parse_script: appends the keys in `script`, a whitespace separated
+ *                       list of <ms>:<key>, where <key> is a single char, one of
+ *                       UP DOWN LEFT RIGHT ENTER SPACE, or #<code>.
+ *                       Example: "400:RIGHT 1200:DOWN 5000:q"
+ * returns 1 on a malformed script or failure, 0 on success.
+ * */
+int led_sim_parse_script(LEDSim *sim, const char *script);
+/* led_sim_attach: `lm` runs on `sim` from now on. NULL goes back to real time.
+ * */
+void led_sim_attach(LEDMatrix *lm, LEDSim *sim);
+/* led_sim_getch: next scripted key that is due, ERR if none (see `blocking`),
+ *                or quit_key once the script is over. led_getch calls it.
+ * */
+int led_sim_getch(LEDSim *sim);
+/* led_sim_hash_frame: records the hash of the current frame of `lm`.
+ *                     led_draw calls it.
+ * */
+void led_sim_hash_frame(LEDSim *sim, LEDMatrix *lm);
+/* led_sim_write_hashes: writes a "<frame> <ms> <hash>" line per recorded
+ *                       frame, then "session <hash>".
+ * returns 1 on failure, 0 on success.
+ * */
+int led_sim_write_hashes(LEDSim *sim, FILE *out);
+/* led_sim_end: destructor for the LEDSim. Detach it first.
+ * */
+void led_sim_end(LEDSim *sim);
+
+#endif // LEDSIM_H
@@ -0,0 +1,78 @@
+#ifndef LEDSPRITE_H
+#define LEDSPRITE_H
+
+/*
+ * This file is part of LEDCurses.
+ *
+ * LEDCurses is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LEDCurses is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LEDCurses.  If not, see <https://www.gnu.org/licenses/>.
+ * */
+
+#include <stdint.h>
+#include "ledcurses.h"
+
+/* LEDSprite: a small bitmap of diode values (and optionally attributes).
+ *            Pixels whose value is `transparent` are not drawn; use a value
+ *            you never draw (e.g. 255) for fully opaque sprites.
+ *            `values` and `attrs` are row-major, rows x cols.
+ * */
+typedef struct led_sprite {
+    int rows;
+    int cols;
+    const uint8_t *values;
+    const uint32_t *attrs;  // ch_attrs of each pixel, or NULL to keep the diode's
+    int transparent;
+} LEDSprite;
+
+/* LEDAtlas: sprites loaded from a file, which is mmap'ed: the sprites point
+ *           straight into it.
+ *
+ *      File format (native endianness):
+ *          header:  char magic[4] = "LEDA", uint32 version = 1, uint32 n_sprites, uint32 reserved
+ *          entries: n_sprites times
+ *                   uint16 rows, uint16 cols, uint8 transparent, uint8 flags (1: has attrs),
+ *                   uint16 reserved, uint32 values_offset, uint32 attrs_offset
+ *          data:    values (uint8) and attrs (uint32, 4-byte aligned) at their offsets
+ * */
+typedef struct led_atlas {
+    LEDSprite *sprites;
+    int n_sprites;
+    void *map;
+    size_t map_size;
+} LEDAtlas;
+
+#define LED_ATLAS_VERSION 1
+#define LED_ATLAS_HAS_ATTRS 1
+
+/* led_atlas_load: maps the atlas at `path`.
+ * returns 1 on failure (missing or malformed file), 0 on success.
+ * */
+int led_atlas_load(LEDAtlas *atlas, const char *path);
+/* led_atlas_save: writes `n_sprites` sprites as an atlas to `path`.
+ * returns 1 on failure (or if something doesn't fit the format: rows and
+ *         cols up to 65535, transparent from 0 to 255, files up to 4 GiB),
+ *         0 on success.
+ * */
+int led_atlas_save(const char *path, const LEDSprite *sprites, int n_sprites);
+/* led_atlas_end: destructor for the LEDAtlas, its sprites become invalid.
+ * */
+void led_atlas_end(LEDAtlas *atlas);
+/* led_blit_sprite: draws `sprite` with its top-left corner at (row, col),
+ *                  clipped to the matrix (row and col may be negative).
+ *      Only the non-transparent pixels are written, and only the LED rows
+ *      the sprite covers are marked dirty. Mono matrices (led_init_mono)
+ *      are left alone.
+ * */
+void led_blit_sprite(LEDMatrix *lm, const LEDSprite *sprite, int row, int col);
+
+#endif // LEDSPRITE_H
@@ -0,0 +1,95 @@
+#ifndef LEDTILES_H
+#define LEDTILES_H
+
+/*
+ * This file is part of LEDCurses.
+ *
+ * LEDCurses is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LEDCurses is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LEDCurses.  If not, see <https://www.gnu.org/licenses/>.
+ * */
+
+#include "ledcurses.h"
+
+/* How a panel is mounted, relative to the logical framebuffer.
+ * Rotations are clockwise; LED_TILE_MIRROR can be or'd to any of them,
+ * and flips the panel left to right after rotating.
+ * */
+#define LED_TILE_ROT_0      0
+#define LED_TILE_ROT_90     1
+#define LED_TILE_ROT_180    2
+#define LED_TILE_ROT_270    3
+#define LED_TILE_MIRROR     4
+
+typedef struct led_tile {
+    LEDMatrix *panel;   // one window (see led_init), owned by the caller
+    SCREEN *screen;     // terminal of the panel if it's not the current one (newterm), or NULL
+    int row;            // top-left corner and size of the region
+    int col;            // of the logical framebuffer it shows
+    int rows;
+    int cols;
+    int transform;      // LED_TILE_*
+    int *remap;         // panel diode index -> logical diode index
+    BIT_FIELD(dirty);   // its region changed since the last led_tiles_draw
+} LEDTile;
+
+/* LEDTiledDisplay: one logical framebuffer spread over several chained panels.
+ *
+ *      Each panel shows a rectangular region, through a remap table computed
+ *      once in led_tiles_add. Writes mark the tile holding the LED as dirty,
+ *      and led_tiles_draw only copies and draws the dirty tiles.
+ *      Regions must not overlap.
+ * */
+typedef struct led_tiled_display {
+    Diode *matrix;      // logical framebuffer, led_rows x led_cols
+    int *tile_of;       // logical diode index -> tile index, -1 if not shown
+    LEDTile *tiles;
+    int n_tiles;
+    int max_tiles;
+    int led_rows;
+    int led_cols;
+} LEDTiledDisplay;
+
+/* led_tiles_init: creates a logical framebuffer of led_rows x led_cols,
+ *                 with room for up to `max_tiles` panels.
+ * returns 1 on failure, 0 on success.
+ * */
+int led_tiles_init(LEDTiledDisplay *display, int led_rows, int led_cols, int max_tiles);
+/* led_tiles_add: shows the region at (row, col) on `panel`, mounted as `transform`.
+ *                The panel must have the size of the region (rows and cols
+ *                swapped for 90 and 270 degree rotations).
+ *                If `screen` is not NULL, it's set_term'd around the drawing.
+ * returns the index of the new tile, or -1 on failure (the region
+ *         doesn't fit, or overlaps the one of another tile).
+ * */
+int led_tiles_add(LEDTiledDisplay *display, LEDMatrix *panel, SCREEN *screen,
+                                            int row, int col, int transform);
+/* led_tiles_get_diode: returns a pointer to the logical Diode at (row, col),
+ *                      or NULL if out of bounds. Its tile is marked dirty.
+ * */
+Diode *led_tiles_get_diode(LEDTiledDisplay *display, int row, int col);
+void led_tiles_set_value(LEDTiledDisplay *display, int row, int col, int value);
+void led_tiles_set_attrs(LEDTiledDisplay *display, int row, int col, int attrs);
+void led_tiles_unset_attrs(LEDTiledDisplay *display, int row, int col, int attrs);
+/* led_tiles_mark_dirty: tells led_tiles_draw that the region at (row, col)
+ *                       of size rows x cols changed. Only needed if you write
+ *                       to display->matrix yourself.
+ * */
+void led_tiles_mark_dirty(LEDTiledDisplay *display, int row, int col, int rows, int cols);
+/* led_tiles_draw: copies the dirty regions to their panels and draws them.
+ * */
+void led_tiles_draw(LEDTiledDisplay *display);
+/* led_tiles_end: destructor for the LEDTiledDisplay. Panels are not led_end'ed.
+ * */
+void led_tiles_end(LEDTiledDisplay *display);
+
+#endif // LEDTILES_H
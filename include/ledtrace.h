@@ -0,0 +1,100 @@
+#ifndef LEDTRACE_H
+#define LEDTRACE_H
+
+/*
+ * This file is part of LEDCurses.
+ *
+ * LEDCurses is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LEDCurses is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LEDCurses.  If not, see <https://www.gnu.org/licenses/>.
+ * */
+
+#include <stdint.h>
+#include <stdio.h>
+#include "ledcurses.h"
+
+#define LED_TRACE_INPUT     0
+#define LED_TRACE_MUTATE    1
+#define LED_TRACE_RASTER    2
+#define LED_TRACE_FLUSH     3
+
+// Latency histogram: exact below 8ns, then 8 buckets per power of two
+#define LED_TRACE_SUB_BUCKETS 8
+#define LED_TRACE_BUCKETS ((64-2)*LED_TRACE_SUB_BUCKETS)
+
+typedef struct led_trace_event {
+    uint64_t begin_ns; // since led_trace_init
+    uint32_t dur_ns;   // 0 for instant events (input, mutation)
+    uint32_t frame;    // frame whose flush presents this event
+    int32_t arg;       // key for input, rows rasterized for raster, cells for flush
+    int32_t type;      // LED_TRACE_*
+} LEDTraceEvent;
+
+/* LEDTrace: input-to-photon tracing for an LEDMatrix.
+ *
+ *      Events are written into a ring of `capacity` preallocated entries
+ *      (older ones get overwritten). A frame goes from one flush to the next:
+ *      input read with led_getch, the first mutation of the matrix (by any
+ *      setter, _fast ones included, led_mark_dirty and the helpers using it,
+ *      or led_history_restore; mono bits are seen when led_mono_draw flags
+ *      them), the rasterization and the flush of led_draw all carry the
+ *      number of the frame that will show them.
+ *      Every flush that follows an input adds the time since the oldest of
+ *      those inputs to the latency histogram.
+ * */
+typedef struct led_trace {
+    LEDTraceEvent *events;
+    uint32_t capacity;
+    uint64_t n_events;      // total recorded, may be more than capacity
+    uint64_t start_ns;
+    uint32_t frame;
+    uint64_t pending_input_ns; // oldest input not presented yet, 0 if none
+    uint64_t latency_hist[LED_TRACE_BUCKETS];
+    uint64_t latency_count;
+    uint64_t latency_sum_ns;
+    uint64_t latency_max_ns;
+    BIT_FIELD(mutated);     // first mutation of this frame already recorded
+} LEDTrace;
+
+/* led_trace_init: allocates room for `capacity` events.
+ * returns 1 on failure, 0 on success.
+ * */
+int led_trace_init(LEDTrace *trace, uint32_t capacity);
+/* led_trace_attach: starts tracing `lm` into `trace`. NULL stops tracing.
+ * */
+void led_trace_attach(LEDMatrix *lm, LEDTrace *trace);
+/* led_trace_now: nanoseconds since led_trace_init.
+ * */
+uint64_t led_trace_now(LEDTrace *trace);
+/* led_trace_input: records an input event. led_getch does it already,
+ *                  call it if you read input some other way.
+ * */
+void led_trace_input(LEDTrace *trace, int key);
+void led_trace_mutation(LEDTrace *trace);
+void led_trace_span(LEDTrace *trace, int type, uint64_t begin_ns, int arg);
+/* led_trace_frame_end: closes the current frame after its flush.
+ * */
+void led_trace_frame_end(LEDTrace *trace, uint64_t flush_end_ns);
+/* led_trace_latency_percentile: input-to-photon latency in ns below which
+ *                               `p` (0 to 100) percent of the frames are.
+ * */
+uint64_t led_trace_latency_percentile(LEDTrace *trace, double p);
+/* led_trace_export_json: writes the recorded events as Chrome trace
+ *                        JSON (chrome://tracing, ui.perfetto.dev).
+ * returns 1 on failure, 0 on success.
+ * */
+int led_trace_export_json(LEDTrace *trace, FILE *out);
+/* led_trace_end: destructor for the LEDTrace. Detach it first.
+ * */
+void led_trace_end(LEDTrace *trace);
+
+#endif // LEDTRACE_H
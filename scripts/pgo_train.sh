@@ -0,0 +1,45 @@
+#!/bin/sh
+# Runs the example binaries in $1 with scripted keystrokes, so that the
+# instrumented library collects a profile of a typical session.
+# The output goes to /dev/null, so no real terminal is needed.
+
+TRAIN_DIR=${1:-./lib/pgo/train}
+export TERM=${TERM:-xterm}
+export LINES=${LINES:-50}
+export COLUMNS=${COLUMNS:-160}
+
+# keys <count> <key>: prints <key> <count> times
+keys() {
+    i=0
+    while [ $i -lt "$1" ]; do
+        printf '%b' "$2"
+        i=$((i+1))
+    done
+}
+
+DOWN='\033[B'
+UP='\033[A'
+LEFT='\033[D'
+RIGHT='\033[C'
+
+run() {
+    bin=$TRAIN_DIR/$1
+    shift
+    [ -x "$bin" ] || return 0
+    echo "Training with $bin $*"
+    "$bin" "$@" > /dev/null
+}
+
+# Game loops: nodelay getch, every key (or its absence) is a frame
+{ keys 150 "$DOWN"; keys 150 "$RIGHT"; keys 150 "$UP"; keys 150 "$LEFT"; printf q; } | run snake 1 20 30
+{ keys 200 "$LEFT"; keys 200 "$RIGHT"; printf q; } | run car 1
+{ for e in 1 2 3 4; do keys 60 x; printf ' '; done; printf q; } | run effects 40 70
+{ keys 150 x; printf ' '; keys 150 x; printf q; } | run life 40 70
+{ keys 200 x; printf q; } | run gauges 24 60
+# Blocking getch: every key is a frame
+{ keys 200 x; printf ' '; } | run xmas
+{ keys 50 "$DOWN"; keys 50 "$RIGHT"; keys 50 "$UP"; keys 50 "$LEFT"; printf '\n'; } | run rpg 20 30
+{ keys 10 "$RIGHT"; keys 6 "$DOWN"; printf '\n'; } | run wall
+{ keys 8 "$RIGHT"; keys 5 "$DOWN"; keys 8 "$LEFT"; keys 10 u; printf q; } | run sketch
+printf x | run led_on
+exit 0
@@ -15,7 +15,13 @@
  * along with LEDCurses.  If not, see <https://www.gnu.org/licenses/>.
  * */
 
+#include <string.h> // memset
 #include "ledcurses.h"
+#include "ledraster.h"
+#include "ledtrace.h"
+#include "ledsim.h"
+#include "ledpresent.h"
+#include "ledquality.h"
 
 void err(LEDMatrix *lm, char *msg) {
     if (lm->dbgwin) {
@@ -35,14 +41,262 @@ void info(LEDMatrix *lm, const char *fmt, ...) {
     va_end(args);
 }
 
+#define MEM_ALIGN(n) (((n) + 15) & ~(size_t)15)
+
+/* Size of a LED for the given window (assuming square/round LEDs)
+ * */
+static int fit_led_size(int led_rows, int led_cols, int rows, int cols, int char_ratio) {
+    int led_size;
+    float rows_per_led = (float)rows/led_rows;
+    float cols_per_led = (float)cols/(led_cols*char_ratio);
+    if (cols_per_led > rows_per_led) {
+        // Height (inter-row space) is what constrains us
+        led_size = (int)rows_per_led;
+
+    } else {
+        // Width (inter-column space) is what constrains us
+        led_size = (int)cols_per_led;
+    }
+
+    // Odd sizes are nicer
+    if (led_size > 5 && led_size%2 == 0) {
+        led_size--;
+    }
+    return led_size;
+}
+
+/* Splits `mem` into the diode matrix (or both mono bitsets), circle mask, cell
+ * buffers and row flags. If `lm` is NULL, only measures. Returns the total size.
+ * */
+static size_t layout_mem(LEDMatrix *lm, char *mem, int led_rows, int led_cols,
+                                                   int rows, int cols, int led_size, int char_ratio, int mono) {
+    int mono_words = (led_cols + 63)/64;
+    size_t matrix_size = mono ? 2*MEM_ALIGN((size_t)led_rows*mono_words*sizeof(uint64_t))
+                              : MEM_ALIGN((size_t)led_rows*led_cols*sizeof(Diode));
+    size_t mask_size = MEM_ALIGN((size_t)(led_size/2)*(led_size*char_ratio/2) + 1);
+    size_t cells_size = MEM_ALIGN((size_t)rows*cols*sizeof(chtype));
+    size_t dirty_size = MEM_ALIGN((size_t)led_rows);
+    if (lm) {
+        lm->matrix = mono ? NULL : (Diode*)mem;
+        lm->mono_bits = mono ? (uint64_t*)mem : NULL;
+        lm->mono_shown = mono ? (uint64_t*)(mem + matrix_size/2) : NULL;
+        lm->mono_words = mono ? mono_words : 0;
+        mem += matrix_size;
+        lm->circle_mask = (unsigned char*)mem;
+        mem += mask_size;
+        lm->cells = (chtype*)mem;
+        mem += cells_size;
+        lm->cells_shown = (chtype*)mem;
+        mem += cells_size;
+        lm->dirty_rows = (unsigned char*)mem;
+        mem += dirty_size;
+        lm->changed_rows = (unsigned char*)mem;
+    }
+    return matrix_size + mask_size + 2*cells_size + 2*dirty_size;
+}
+
+size_t led_mem_size(int led_rows, int led_cols, int win_rows, int win_cols) {
+    int char_ratio = 2;
+    int led_size = fit_led_size(led_rows, led_cols, win_rows, win_cols, char_ratio);
+    return layout_mem(NULL, NULL, led_rows, led_cols, win_rows, win_cols, led_size, char_ratio, 0);
+}
+
+size_t led_mono_mem_size(int led_rows, int led_cols, int win_rows, int win_cols) {
+    int char_ratio = 2;
+    int led_size = fit_led_size(led_rows, led_cols, win_rows, win_cols, char_ratio);
+    return layout_mem(NULL, NULL, led_rows, led_cols, win_rows, win_cols, led_size, char_ratio, 1);
+}
+
+/* Everything that depends on the LED size: derived sizes, circle mask
+ * and grid availability. The circle mask has room for up to max_led_size.
+ * */
+static void set_led_size(LEDMatrix *lm, int led_size) {
+    lm->led_size = led_size;
+
+    // Don't repeat calculations
+    lm->led_size_ratioed = lm->led_size*lm->char_ratio;
+    lm->led_halfsize_sq = SQUARE(lm->led_size/2);
+    lm->led_halfsize_m1_sq = SQUARE(lm->led_size/2 - 1);
+
+    // Which cells of a quadrant belong to the edge and to the inside
+    // of the circle, the same for every diode.
+    int mask_rows = lm->led_size/2;
+    int mask_cols = lm->led_size_ratioed/2;
+    for (int d_i = 0; d_i < mask_rows; d_i++) {
+        for (int d_j = 0; d_j < mask_cols; d_j++) {
+            int dist_squared = SQUARE(d_i) + SQUARE((float)d_j/lm->char_ratio);
+            // /* nope */ if (lm->led_halfsize_sq <= dist_squared && dist_squared <= halfsize_p1_squared) {
+            // /* too much */ if (lm->led_halfsize_m1_sq <= dist_squared && dist_squared <= halfsize_p1_squared) {
+            // /* too little */ if (lm->led_halfsize_sq == dist_squared) {
+            if (lm->led_halfsize_m1_sq <= dist_squared && dist_squared <= lm->led_halfsize_sq) {
+                lm->circle_mask[d_i*mask_cols + d_j] = 1;
+            } else if (dist_squared < lm->led_halfsize_m1_sq) {
+                lm->circle_mask[d_i*mask_cols + d_j] = 2;
+            } else {
+                lm->circle_mask[d_i*mask_cols + d_j] = 0;
+            }
+        }
+    }
+
+    // Can we fit a grid? With it, diodes are (led_size+1) cells apart,
+    // and the last one doesn't need a grid line after it.
+    int pitch = lm->led_size + 1;
+    lm->grid_available = 0;
+    if ((pitch*lm->led_rows - 1 <= lm->win_rows) &&
+        (lm->char_ratio*pitch*lm->led_cols - lm->char_ratio <= lm->win_cols)) {
+        lm->grid_available = 1;
+    }
+}
+
+/* Everything led_init does once the window size is known: LED size,
+ * buffers, circle mask and default chars. A `mono_value` other than 0
+ * makes a led_init_mono matrix.
+ * */
+static int setup_matrix(LEDMatrix *lm, int led_rows, int led_cols, int rows, int cols,
+                                       int mono_value, void *mem, size_t mem_size) {
+    if (led_rows < 1 || led_cols < 1) {
+        err(lm, "Need at least one LED\n");
+        return 1;
+    }
+    // Check if we can fit enough LEDs
+    if (led_rows > rows || led_cols > cols) {
+        err(lm, "Cannot have more than one LED per character\n");
+        return 1;
+    }
+
+    lm->led_rows = led_rows;
+    lm->led_cols = led_cols;
+    lm->mono_value = mono_value;
+
+    // Cells usually are not a square
+    lm->char_ratio = 2;
+    lm->max_led_size = fit_led_size(led_rows, led_cols, rows, cols, lm->char_ratio);
+
+    // Everything the matrix needs lives in a single block: either the
+    // caller's or one we allocate here.
+    size_t needed = layout_mem(NULL, NULL, led_rows, led_cols, rows, cols,
+                                           lm->max_led_size, lm->char_ratio, mono_value != 0);
+    if (mem) {
+        if (mem_size < needed) {
+            err(lm, "Memory given to led_init is too small\n");
+            return 1;
+        }
+        memset(mem, 0, needed);
+    } else {
+        mem = calloc(1, needed);
+        if (!mem) {
+            err(lm, "Couldn't allocate Diode matrix\n");
+            return 1;
+        }
+        lm->owns_mem = 1;
+    }
+    lm->mem = mem;
+    layout_mem(lm, (char*)mem, led_rows, led_cols, rows, cols, lm->max_led_size, lm->char_ratio,
+                                                                mono_value != 0);
+
+    // Inner representation of the LEDs is lm->matrix (or lm->mono_bits), all off.
+    // Cell buffers: lm->cells is what we want on the window, and
+    // lm->cells_shown what is already there. A zero cell is one no
+    // diode ever touches.
+    memset(lm->dirty_rows, 1, led_rows);
+    memset(lm->changed_rows, 1, led_rows);
+    lm->mono_redraw = 1;
+
+    lm->grid_enabled = 0;
+    set_led_size(lm, lm->max_led_size);
+
+    // Default chars
+    lm->ch_edge_on = A_BOLD | 'O';
+    lm->ch_edge_off = 'O';
+    lm->ch_inner_on = A_BOLD | '+'; //A_ALTCHARSET | A_BOLD | ACS_CKBOARD;
+    lm->ch_inner_off = ' ';
+
+    return 0;
+}
+
+static void clear_fields(LEDMatrix *lm) {
+    lm->win = NULL;
+    lm->dbgwin = NULL;
+    lm->i_started_curses = 0;
+    lm->mem = NULL;
+    lm->owns_mem = 0;
+    lm->matrix = NULL;
+    lm->mono_bits = NULL;
+    lm->mono_shown = NULL;
+    lm->mono_words = 0;
+    lm->mono_value = 0;
+    lm->raster_pool = NULL;
+    lm->trace = NULL;
+    lm->sim = NULL;
+    lm->presenter = NULL;
+    lm->quality = NULL;
+}
+
+/* Undoes the ncurses side of a failed led_init_mem: windows and curses itself.
+ * */
+static int init_failed(LEDMatrix *lm) {
+    if (lm->dbgwin) {
+        delwin(lm->dbgwin);
+        lm->dbgwin = NULL;
+    }
+    if (lm->win) {
+        delwin(lm->win);
+        lm->win = NULL;
+    }
+    if (lm->i_started_curses) {
+        endwin();
+        lm->i_started_curses = 0;
+    }
+    return 1;
+}
+
 int led_init(LEDMatrix *lm, int led_rows, int led_cols,
                             int rows, int cols,
                             int begin_row, int begin_col, int curses_started, int debug) {
+    return led_init_mem(lm, led_rows, led_cols, rows, cols, begin_row, begin_col,
+                            curses_started, debug, NULL, 0);
+}
+
+static int init_headless(LEDMatrix *lm, int led_rows, int led_cols, int rows, int cols,
+                                        int mono_value, void *mem, size_t mem_size) {
     if (!lm) {
         err(lm, "LEDMatrix pointer mustn't be null\n");
         return 1;
     }
-    lm->dbgwin = NULL;
+    clear_fields(lm);
+    if (rows <= 0 || cols <= 0) {
+        err(lm, "Headless matrices need an explicit size\n");
+        return 1;
+    }
+    lm->win_rows = rows;
+    lm->win_cols = cols;
+    lm->uses_color = 1;
+    return setup_matrix(lm, led_rows, led_cols, rows, cols, mono_value, mem, mem_size);
+}
+
+int led_init_headless(LEDMatrix *lm, int led_rows, int led_cols, int rows, int cols,
+                                     void *mem, size_t mem_size) {
+    return init_headless(lm, led_rows, led_cols, rows, cols, 0, mem, mem_size);
+}
+
+int led_init_mono_headless(LEDMatrix *lm, int led_rows, int led_cols, int rows, int cols,
+                                          int on_value, void *mem, size_t mem_size) {
+    if (!on_value) {
+        err(lm, "Lit LEDs can't have value 0\n");
+        return 1;
+    }
+    return init_headless(lm, led_rows, led_cols, rows, cols, on_value, mem, mem_size);
+}
+
+static int init_window(LEDMatrix *lm, int led_rows, int led_cols,
+                                      int rows, int cols,
+                                      int begin_row, int begin_col, int curses_started, int debug,
+                                      int mono_value, void *mem, size_t mem_size) {
+    if (!lm) {
+        err(lm, "LEDMatrix pointer mustn't be null\n");
+        return 1;
+    }
+    clear_fields(lm);
 
     // Start NCurses if we're asked to do so
     lm->uses_color = 0;
@@ -53,6 +307,9 @@ int led_init(LEDMatrix *lm, int led_rows, int led_cols,
             start_color();
             lm->uses_color = 1;
         }
+    } else if (has_colors() && COLOR_PAIRS > 0) {
+        // Whoever started curses also started colors (e.g. a previous led_init)
+        lm->uses_color = 1;
     }
     refresh();
 
@@ -77,7 +334,7 @@ int led_init(LEDMatrix *lm, int led_rows, int led_cols,
     lm->win = newwin(rows, cols, begin_row, begin_col);
     if (!lm->win) {
         err(lm, "Couldn't create window\n");
-        return 1;
+        return init_failed(lm);
     }
 
     // Check if either rows or cols was 0
@@ -93,68 +350,22 @@ int led_init(LEDMatrix *lm, int led_rows, int led_cols,
         lm->dbgwin = newwin(DEBUG_LINES, cols, begin_row+rows, begin_col);
         if (!lm->dbgwin) {
             err(lm, "Couldn't create debug window\n");
-            return 1;
+            return init_failed(lm);
         }
         scrollok(lm->dbgwin, 1);
     }
 
-    // Check if we can fit enough LEDs
-    if (led_rows > rows || led_cols > cols) {
-        err(lm, "Cannot have more than one LED per character\n");
-        return 1;
-    }
-
-    lm->led_rows = led_rows;
-    lm->led_cols = led_cols;
-
-    // Inner representation of the LEDs
-    lm->matrix = (Diode*)calloc(rows*cols, sizeof(Diode));
-    if (!lm->matrix) {
-        err(lm, "Couldn't allocate Diode matrix\n");
-        return 1;
-    }
-
-    // Cells usually are not a square
-    lm->char_ratio = 2;
-
-    // Calculate the LED diameter/width (assuming square/round LEDs)
-    float rows_per_led = (float)rows/led_rows;
-    float cols_per_led = (float)cols/(led_cols*lm->char_ratio);
-    if (cols_per_led > rows_per_led) {
-        // Height (inter-row space) is what constrains us
-        lm->led_size = (int)rows_per_led;
-
-    } else {
-        // Width (inter-column space) is what constrains us
-        lm->led_size = (int)cols_per_led;
-    }
-
-    // Odd sizes are nicer
-    if (lm->led_size > 5 && lm->led_size%2 == 0) {
-        lm->led_size--;
-    }
-
-    // Don't repeat calculations
-    lm->led_size_ratioed = lm->led_size*lm->char_ratio;
-    lm->led_halfsize_sq = SQUARE(lm->led_size/2);
-    lm->led_halfsize_m1_sq = SQUARE(lm->led_size/2 - 1);
-
-    // Can we fit a grid?
-    lm->grid_enabled = 0;
-    lm->grid_available = 0;
-    if ((rows - lm->led_size*led_rows >= (led_rows-1)) &&
-        (cols - lm->led_size_ratioed*led_cols >= (led_cols-1))) {
-        lm->grid_available = 1;
+    if (setup_matrix(lm, led_rows, led_cols, rows, cols, mono_value, mem, mem_size)) {
+        return init_failed(lm);
     }
 
-    // Default chars
-    lm->ch_edge_on = A_BOLD | 'O';
-    lm->ch_edge_off = 'O';
-    lm->ch_inner_on = A_BOLD | '+'; //A_ALTCHARSET | A_BOLD | ACS_CKBOARD;
-    lm->ch_inner_off = ' ';
-
     if (lm->uses_color) {
-        init_pair(1, COLOR_RED, COLOR_BLACK);
+        // Red on black by default, but don't override the caller's own pair 1
+        // (an undefined pair reads as black on black)
+        short fg, bg;
+        if (lm->i_started_curses || pair_content(1, &fg, &bg) == ERR || (fg == 0 && bg == 0)) {
+            init_pair(1, COLOR_RED, COLOR_BLACK);
+        }
     } else {
         lm->ch_edge_on |= A_REVERSE;
     }
@@ -172,6 +383,26 @@ int led_init(LEDMatrix *lm, int led_rows, int led_cols,
     return 0;
 }
 
+int led_init_mem(LEDMatrix *lm, int led_rows, int led_cols,
+                                int rows, int cols,
+                                int begin_row, int begin_col, int curses_started, int debug,
+                                void *mem, size_t mem_size) {
+    return init_window(lm, led_rows, led_cols, rows, cols, begin_row, begin_col,
+                           curses_started, debug, 0, mem, mem_size);
+}
+
+int led_init_mono(LEDMatrix *lm, int led_rows, int led_cols,
+                                 int rows, int cols,
+                                 int begin_row, int begin_col, int curses_started, int debug,
+                                 int on_value, void *mem, size_t mem_size) {
+    if (!on_value) {
+        err(lm, "Lit LEDs can't have value 0\n");
+        return 1;
+    }
+    return init_window(lm, led_rows, led_cols, rows, cols, begin_row, begin_col,
+                           curses_started, debug, on_value, mem, mem_size);
+}
+
 /* led_set_grid: if `value` is not 0, will try to enable the grid,
  *               otherwise, disables the grid
  * returns 1 on failure, 0 on success.
@@ -180,16 +411,63 @@ int led_set_grid(LEDMatrix *lm, int value) {
     if (value && !lm->grid_available) {
         return 1;
     }
+    if (lm->grid_enabled != (value ? 1 : 0)) {
+        // Diodes move around: start over from a blank window
+        if (lm->win) {
+            werase(lm->win);
+        }
+        memset(lm->cells, 0, lm->win_rows*lm->win_cols*sizeof(chtype));
+        memset(lm->cells_shown, 0, lm->win_rows*lm->win_cols*sizeof(chtype));
+        led_mark_dirty(lm, 0, lm->led_rows);
+        lm->mono_redraw = 1;
+    }
     lm->grid_enabled = value ? 1 : 0;
     return 0;
 }
 
+/* led_set_led_size: draws the LEDs with a size of `led_size` cell rows,
+ *                   from 1 to lm->max_led_size (the size led_init chose).
+ * returns 1 on failure, 0 on success.
+ * */
+int led_set_led_size(LEDMatrix *lm, int led_size) {
+    if (led_size < 1 || led_size > lm->max_led_size) {
+        return 1;
+    }
+    if (led_size == lm->led_size) {
+        return 0;
+    }
+    set_led_size(lm, led_size);
+    if (lm->grid_enabled && !lm->grid_available) {
+        lm->grid_enabled = 0;
+    }
+    // Diodes move around: start over from a blank window
+    if (lm->win) {
+        werase(lm->win);
+    }
+    memset(lm->cells, 0, lm->win_rows*lm->win_cols*sizeof(chtype));
+    memset(lm->cells_shown, 0, lm->win_rows*lm->win_cols*sizeof(chtype));
+    led_mark_dirty(lm, 0, lm->led_rows);
+    lm->mono_redraw = 1;
+    return 0;
+}
+
+static int in_grid(LEDMatrix *lm, int row, int col) {
+    if (row < 0 || row >= lm->led_rows || col < 0 || col >= lm->led_cols) {
+        err(lm, "LED position out of grid\n");
+        return 0;
+    }
+    return 1;
+}
+
 /* led_get_diode: returns a pointer to the Diode at the given (row, col).
- *                If out of bounds, will return NULL.
+ *                If out of bounds (or on a led_init_mono matrix), will return NULL.
  * */
 Diode *led_get_diode(LEDMatrix *lm, int row, int col) {
-    if (row > lm->led_rows || col > lm->led_cols) {
-        err(lm, "LED position out of grid\n");
+    if (!in_grid(lm, row, col)) {
+        return NULL;
+    }
+    if (!lm->matrix) {
+        err(lm, "Mono matrices have no Diodes\n");
         return NULL;
     }
     return &(lm->matrix[row*lm->led_cols + col]);
@@ -198,48 +476,61 @@ Diode *led_get_diode(LEDMatrix *lm, int row, int col) {
 /* led_diode_set_value: if `value` is 0, the diode is considered off
  *                      otherwise, diode will be colored with the
  *                      COLOR_PAIR(value).
- *      By default, only COLOR_PAIR(1) is initialized,  but you can
+ *      By default, only COLOR_PAIR(1) is initialized (as red, unless you had
+ *      already defined it), but you can
  *      use whatever value you may have init_pair'd.
  *
  *      Using an uninitialized value is undefined.
  * */
 void led_diode_set_value(LEDMatrix *lm, int row, int col, int value) {
+    if (lm->mono_bits) {
+        if (!in_grid(lm, row, col)) return;
+        uint64_t *word = &lm->mono_bits[row*lm->mono_words + (col >> 6)];
+        uint64_t bit = (uint64_t)1 << (col & 63);
+        *word = value ? *word | bit : *word & ~bit;
+        lm->dirty_rows[row] = 1;
+        lm->changed_rows[row] = 1;
+        if (lm->trace) led_trace_mutation(lm->trace);
+        return;
+    }
     Diode *diode = led_get_diode(lm, row, col);
+    if (!diode) return;
     diode->value = value;
+    lm->dirty_rows[row] = 1;
+    lm->changed_rows[row] = 1;
+    if (lm->trace) led_trace_mutation(lm->trace);
 }
 
 void led_diode_set_attrs(LEDMatrix *lm, int row, int col, int attrs) {
     Diode *diode = led_get_diode(lm, row, col);
+    if (!diode) return;
     diode->ch_attrs |= attrs;
+    lm->dirty_rows[row] = 1;
+    lm->changed_rows[row] = 1;
+    if (lm->trace) led_trace_mutation(lm->trace);
 }
 
 void led_diode_unset_attrs(LEDMatrix *lm, int row, int col, int attrs) {
     Diode *diode = led_get_diode(lm, row, col);
+    if (!diode) return;
     diode->ch_attrs &= ~attrs;
+    lm->dirty_rows[row] = 1;
+    lm->changed_rows[row] = 1;
+    if (lm->trace) led_trace_mutation(lm->trace);
 }
 
-void led_draw_grid(LEDMatrix *lm);
-
-/* led_draw: draw the LEDMatrix to the window.
- *           call this after each change (for instance,
- *           led_diode_set_value calls)
- * */
-void led_draw(LEDMatrix *lm) {
-    for (int i=0; i<lm->led_rows; i++) {
-        for (int j=0; j<lm->led_cols; j++) {
-            led_draw_diode(lm, i, j);
-        }
-    }
-
-    if (lm->grid_enabled) {
-        info(lm, "Grid is enabled. Drawing it.\n");
-        led_draw_grid(lm);
-    } else {
-        info(lm, "Grid is not enabled.\n");
+void led_mark_dirty(LEDMatrix *lm, int row_begin, int row_end) {
+    if (row_begin < 0) row_begin = 0;
+    if (row_end > lm->led_rows) row_end = lm->led_rows;
+    if (row_begin < row_end) {
+        memset(lm->dirty_rows + row_begin, 1, row_end - row_begin);
+        memset(lm->changed_rows + row_begin, 1, row_end - row_begin);
+        if (lm->trace) led_trace_mutation(lm->trace);
     }
-    wrefresh(lm->win);
 }
 
+void led_draw_grid(LEDMatrix *lm);
+
 int led_get_row_center_pos(LEDMatrix *lm, int led_row) {
     int grid_cell = lm->grid_enabled ? 1 : 0;
     return led_row*(lm->led_size + grid_cell) + (lm->led_size)/2;
@@ -250,55 +541,237 @@ int led_get_col_center_pos(LEDMatrix *lm, int led_col) {
     return led_col*lm->char_ratio*(lm->led_size + grid_cell) + lm->led_size_ratioed/2;
 }
 
-void led_draw_diode(LEDMatrix *lm, int led_row, int led_col) {
+static void raster_diode(LEDMatrix *lm, int led_row, int led_col) {
     // Center of diode
     int center_row = led_get_row_center_pos(lm, led_row);
     int center_col = led_get_col_center_pos(lm, led_col);
-    Diode *diode = led_get_diode(lm, led_row, led_col);
-
-    /*
-    int halfsize_squared = SQUARE(lm->led_size/2);
-    int halfsize_m1_squared = SQUARE(lm->led_size/2-1);
-    int halfsize_p1_squared = SQUARE(lm->led_size/2+1);
-    */
-
-    if (diode->value && lm->uses_color) {
-        wattrset(lm->win, COLOR_PAIR(diode->value));
-        info(lm, "Diode (%d, %d) has color %d\n.", led_row, led_col, diode->value);
+    int value, attrs;
+    if (lm->matrix) {
+        Diode *diode = led_diode_at(lm, led_row, led_col);
+        value = diode->value;
+        attrs = diode->ch_attrs;
     } else {
-        wattrset(lm->win, COLOR_PAIR(0));
+        uint64_t word = lm->mono_bits[led_row*lm->mono_words + (led_col >> 6)];
+        value = (word >> (led_col & 63)) & 1 ? lm->mono_value : 0;
+        attrs = 0;
     }
+    chtype *cells = lm->cells;
+    int win_rows = lm->win_rows;
+    int win_cols = lm->win_cols;
+
+    chtype pair = (value && lm->uses_color) ? COLOR_PAIR(value) : COLOR_PAIR(0);
+    chtype edge = (value ? lm->ch_edge_on : lm->ch_edge_off) | attrs | pair;
+    chtype inner = (value ? lm->ch_inner_on : lm->ch_inner_off) | attrs | pair;
 
     // The double loop only covers the lower-right part of the diode (positive offsets)
-    // but it will paint the four quadrants each time
+    // but it will paint the four quadrants each time.
+    // Cells outside the window are clipped: d_j < right (left) stays inside
+    // on the right (left) side, and a row_down past the bottom just repeats row_up.
+    int mask_cols = lm->led_size_ratioed/2;
+    int right = win_cols - center_col;
+    int left = center_col + 1;
+    if (right > mask_cols) right = mask_cols;
+    if (left > mask_cols) left = mask_cols;
     for (int d_i = 0; d_i < lm->led_size/2; d_i++) {
-        for (int d_j = 0; d_j < lm->led_size_ratioed/2; d_j++) {
-            int dist_squared = SQUARE(d_i) + SQUARE((float)d_j/lm->char_ratio);
-            // Edge of the diode (circle)
-            chtype to_draw;
-            // /* nope */ if (lm->led_halfsize_sq <= dist_squared && dist_squared <= halfsize_p1_squared) {
-            // /* too much */ if (lm->led_halfsize_m1_sq <= dist_squared && dist_squared <= halfsize_p1_squared) {
-            // /* too little */ if (lm->led_halfsize_sq == dist_squared) {
-            if (lm->led_halfsize_m1_sq <= dist_squared && dist_squared <= lm->led_halfsize_sq) {
-                to_draw = diode->value ? lm->ch_edge_on : lm->ch_edge_off;
-            } else if (dist_squared < lm->led_halfsize_m1_sq) {
-                to_draw = diode->value ? lm->ch_inner_on : lm->ch_inner_off;
-            } else {
-                continue;
+        if (center_row-d_i >= win_rows) {
+            continue;
+        }
+        const unsigned char *mask = lm->circle_mask + d_i*mask_cols;
+        chtype *row_up = cells + (center_row-d_i)*win_cols + center_col;
+        chtype *row_down = center_row+d_i < win_rows ? row_up + 2*d_i*win_cols : row_up;
+        for (int d_j = 0; d_j < right; d_j++) {
+            if (mask[d_j]) {
+                chtype to_draw = mask[d_j] == 1 ? edge : inner;
+                row_down[d_j] = to_draw;
+                row_up[d_j] = to_draw;
+            }
+        }
+        for (int d_j = 0; d_j < left; d_j++) {
+            if (mask[d_j]) {
+                chtype to_draw = mask[d_j] == 1 ? edge : inner;
+                row_down[-d_j] = to_draw;
+                row_up[-d_j] = to_draw;
             }
-            to_draw |= diode->ch_attrs;
-            mvwaddch(lm->win, center_row+d_i, center_col+d_j, to_draw);
-            mvwaddch(lm->win, center_row-d_i, center_col+d_j, to_draw);
-            mvwaddch(lm->win, center_row+d_i, center_col-d_j, to_draw);
-            mvwaddch(lm->win, center_row-d_i, center_col-d_j, to_draw);
         }
     }
 
-    mvwprintw(lm->win, center_row, center_col, "x");
+    if (center_row < win_rows && center_col < win_cols) {
+        cells[center_row*win_cols + center_col] = 'x' | pair;
+    }
+}
+
+void led_raster_rows(LEDMatrix *lm, int row_begin, int row_end) {
+    for (int i=row_begin; i<row_end; i++) {
+        if (!lm->dirty_rows[i]) {
+            continue;
+        }
+        if (!lm->mono_bits || lm->mono_redraw) {
+            for (int j=0; j<lm->led_cols; j++) {
+                raster_diode(lm, i, j);
+            }
+            if (lm->mono_bits) {
+                memcpy(lm->mono_shown + (size_t)i*lm->mono_words, lm->mono_bits + (size_t)i*lm->mono_words,
+                       lm->mono_words*sizeof(uint64_t));
+            }
+            continue;
+        }
+        // Mono: only the LEDs whose bit differs from the rasterized one
+        const uint64_t *bits = lm->mono_bits + (size_t)i*lm->mono_words;
+        uint64_t *shown = lm->mono_shown + (size_t)i*lm->mono_words;
+        for (int w=0; w<lm->mono_words; w++) {
+            uint64_t changed = bits[w] ^ shown[w];
+            shown[w] = bits[w];
+            while (changed) {
+                raster_diode(lm, i, w*64 + __builtin_ctzll(changed));
+                changed &= changed - 1;
+            }
+        }
+    }
+}
+
+/* Writes to the window the cells in rows [cell_row_begin, cell_row_end)
+ * and cols [cell_col_begin, cell_col_end) that differ from what's shown.
+ * Returns how many were written.
+ * */
+static int emit_cells(LEDMatrix *lm, int cell_row_begin, int cell_row_end,
+                                      int cell_col_begin, int cell_col_end) {
+    if (cell_row_begin < 0) cell_row_begin = 0;
+    if (cell_row_end > lm->win_rows) cell_row_end = lm->win_rows;
+    if (cell_col_begin < 0) cell_col_begin = 0;
+    if (cell_col_end > lm->win_cols) cell_col_end = lm->win_cols;
+
+    int written = 0;
+    if (!lm->win) {
+        // Headless: nothing to write to
+        for (int r=cell_row_begin; r<cell_row_end; r++) {
+            chtype *cells = lm->cells + r*lm->win_cols;
+            chtype *shown = lm->cells_shown + r*lm->win_cols;
+            for (int c=cell_col_begin; c<cell_col_end; c++) {
+                written += cells[c] != shown[c];
+                shown[c] = cells[c];
+            }
+        }
+        return written;
+    }
+    for (int r=cell_row_begin; r<cell_row_end; r++) {
+        chtype *cells = lm->cells + r*lm->win_cols;
+        chtype *shown = lm->cells_shown + r*lm->win_cols;
+        for (int c=cell_col_begin; c<cell_col_end; c++) {
+            if (cells[c] != shown[c]) {
+                mvwaddch(lm->win, r, c, cells[c]);
+                shown[c] = cells[c];
+                written++;
+            }
+        }
+    }
+    return written;
+}
+
+/* led_draw: draw the LEDMatrix to the window.
+ *           call this after each change (for instance,
+ *           led_diode_set_value calls)
+ *      Only the LED rows changed since the last call are rasterized into
+ *      lm->cells, and only the cells that changed are written to the window.
+ *      With an LEDPresenter started, it only publishes the frame (ledpresent.h),
+ *      and an LEDQuality may skip it (ledquality.h).
+ * */
+void led_draw(LEDMatrix *lm) {
+    if (lm->presenter) {
+        led_presenter_publish(lm->presenter);
+        return;
+    }
+    if (lm->quality && led_quality_skip(lm->quality)) {
+        return;
+    }
+    uint64_t trace_begin = lm->trace ? led_trace_now(lm->trace) : 0;
+    if (lm->raster_pool) {
+        led_raster_pool_run(lm->raster_pool);
+    } else {
+        led_raster_rows(lm, 0, lm->led_rows);
+    }
+    lm->mono_redraw = 0;
+
+    int n_dirty = 0;
+    if (lm->trace) {
+        for (int i=0; i<lm->led_rows; i++) {
+            n_dirty += lm->dirty_rows[i];
+        }
+        led_trace_span(lm->trace, LED_TRACE_RASTER, trace_begin, n_dirty);
+        trace_begin = led_trace_now(lm->trace);
+    }
+
+    // Only one thread talks to ncurses
+    if (lm->win) {
+        wattrset(lm->win, A_NORMAL);
+    }
+    int pitch = lm->led_size + (lm->grid_enabled ? 1 : 0);
+    int n_written = 0;
+    for (int i=0; i<lm->led_rows; i++) {
+        if (lm->dirty_rows[i]) {
+            n_written += emit_cells(lm, i*pitch, i*pitch + (lm->led_size ? lm->led_size : 1), 0, lm->win_cols);
+            lm->dirty_rows[i] = 0;
+        }
+    }
+
+    if (lm->win) {
+        if (lm->grid_enabled) {
+            info(lm, "Grid is enabled. Drawing it.\n");
+            led_draw_grid(lm);
+        } else {
+            info(lm, "Grid is not enabled.\n");
+        }
+        wrefresh(lm->win);
+    }
+    if (lm->quality) {
+        led_quality_frame_done(lm->quality, n_written);
+    }
+    if (lm->sim) {
+        led_sim_hash_frame(lm->sim, lm);
+    }
+
+    if (lm->trace) {
+        led_trace_span(lm->trace, LED_TRACE_FLUSH, trace_begin, n_written);
+        led_trace_frame_end(lm->trace, led_trace_now(lm->trace));
+    }
+}
+
+void led_draw_diode(LEDMatrix *lm, int led_row, int led_col) {
+    if (!in_grid(lm, led_row, led_col)) return;
+    if (lm->matrix && lm->matrix[led_row*lm->led_cols + led_col].value && lm->uses_color) {
+        info(lm, "Diode (%d, %d) has color %d\n.", led_row, led_col,
+                 lm->matrix[led_row*lm->led_cols + led_col].value);
+    }
+
+    raster_diode(lm, led_row, led_col);
+    int center_row = led_get_row_center_pos(lm, led_row);
+    int center_col = led_get_col_center_pos(lm, led_col);
+    if (lm->win) {
+        wattrset(lm->win, A_NORMAL);
+    }
+    emit_cells(lm, center_row - lm->led_size/2, center_row + lm->led_size/2 + 1,
+                   center_col - lm->led_size_ratioed/2, center_col + lm->led_size_ratioed/2 + 1);
+}
+
+int led_set_raster_threads(LEDMatrix *lm, int n_threads) {
+    if (lm->raster_pool) {
+        led_raster_pool_end(lm->raster_pool);
+        lm->raster_pool = NULL;
+    }
+    if (n_threads <= 1) {
+        return 0;
+    }
+    lm->raster_pool = led_raster_pool_init(lm, n_threads);
+    if (!lm->raster_pool) {
+        err(lm, "Couldn't start raster threads\n");
+        return 1;
+    }
+    return 0;
 }
 
 void led_draw_grid(LEDMatrix *lm) {
-    int count;
+    if (!lm->win) {
+        return;
+    }
     for (int i=lm->led_size, count=0; i<lm->win_rows &&
                                       count < (lm->led_rows-1); i+=(lm->led_size+1), count++) {
         mvwhline(lm->win, i, 0, ACS_HLINE, lm->win_cols);
@@ -316,18 +789,68 @@ void led_draw_grid(LEDMatrix *lm) {
 /* led_getch: the getch for this window
  * */
 int led_getch(LEDMatrix *lm) {
-    return wgetch(lm->win);
+    int key;
+    if (lm->quality) {
+        // The frame skipped last would stay off screen while we wait
+        led_quality_flush(lm->quality, lm->win && !is_nodelay(lm->win));
+    }
+    if (lm->presenter) {
+        key = led_presenter_getch(lm->presenter);
+    } else if (lm->sim) {
+        key = led_sim_getch(lm->sim);
+    } else if (lm->win) {
+        key = wgetch(lm->win);
+    } else {
+        key = ERR;
+    }
+    if (lm->trace && key != ERR) {
+        led_trace_input(lm->trace, key);
+    }
+    return key;
+}
+
+/* led_napms: napms, or advancing the virtual clock if an LEDSim is attached
+ * */
+int led_napms(LEDMatrix *lm, int ms) {
+    if (lm->sim) {
+        lm->sim->now_ms += ms;
+        return OK;
+    }
+    if (lm->quality) {
+        return led_quality_napms(lm->quality, ms);
+    }
+    return napms(ms);
 }
 
 /* led_end: destructor for the LEDMatrix.
  *          Be sure to call it at the end to prevent memory leaks.
+ *          It deletes the LED and debug windows, and ends curses if led_init started it.
+ *          Memory given to led_init_mem is not touched.
  * */
 int led_end(LEDMatrix *lm) {
     int ret = 0;
+    if (lm->presenter) {
+        led_presenter_stop(lm->presenter);
+    }
+    if (lm->raster_pool) {
+        led_raster_pool_end(lm->raster_pool);
+        lm->raster_pool = NULL;
+    }
+    if (lm->dbgwin) {
+        delwin(lm->dbgwin);
+        lm->dbgwin = NULL;
+    }
+    if (lm->win) {
+        delwin(lm->win);
+        lm->win = NULL;
+    }
     if (lm->i_started_curses) {
         ret = endwin();
     }
-    free(lm->matrix);
+    if (lm->owns_mem) {
+        free(lm->mem);
+    }
+    lm->mem = NULL;
     return ret != ERR;
 }
 
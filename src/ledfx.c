@@ -0,0 +1,195 @@
+/*
+ * This file is part of LEDCurses.
+ *
+ * LEDCurses is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LEDCurses is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LEDCurses.  If not, see <https://www.gnu.org/licenses/>.
+ * */
+
+#include <math.h>   // sin, only to fill the table
+#include <string.h> // memset
+#include "ledfx.h"
+
+static uint8_t sin_table[256];
+static int sin_table_ready = 0;
+
+static void fill_sin_table(void) {
+    for (int i=0; i<256; i++) {
+        sin_table[i] = (uint8_t)lround(128 + 127*sin(i*2*M_PI/256));
+    }
+    sin_table_ready = 1;
+}
+
+uint8_t led_fx_sin8(uint8_t phase) {
+    return sin_table[phase];
+}
+
+uint8_t led_fx_hash8(uint32_t seed, int x, int y, int z) {
+    uint32_t h = seed ^ ((uint32_t)x*0x8da6b343u) ^ ((uint32_t)y*0xd8163841u) ^ ((uint32_t)z*0xcb1ab31fu);
+    h ^= h >> 15;
+    h *= 0x2c1b3c6du;
+    h ^= h >> 12;
+    return (uint8_t)(h >> 24);
+}
+
+int led_fx_init(LEDFx *fx, LEDMatrix *lm) {
+    if (!fx || !lm) {
+        return 1;
+    }
+    if (!lm->matrix) {
+        err(lm, "Effects need a Diode matrix, not a mono one\n");
+        return 1;
+    }
+    if (!sin_table_ready) {
+        fill_sin_table();
+    }
+    fx->lm = lm;
+    fx->t = 0;
+    fx->speed = 2;
+    fx->seed = 0x9e3779b9u;
+    fx->user = NULL;
+    fx->row_buf = (uint8_t*)calloc(lm->led_cols, 1);
+    fx->state = (uint8_t*)calloc(lm->led_rows*lm->led_cols, 1);
+    if (!fx->row_buf || !fx->state) {
+        err(lm, "Couldn't allocate effect buffers\n");
+        led_fx_end(fx);
+        return 1;
+    }
+    int values[2] = {0, 1};
+    led_fx_set_palette(fx, values, 2);
+    return 0;
+}
+
+int led_fx_set_palette(LEDFx *fx, const int *values, int n) {
+    if (!fx || !values || n <= 0) {
+        return 1;
+    }
+    for (int i=0; i<256; i++) {
+        fx->palette[i] = values[i*n/256];
+    }
+    return 0;
+}
+
+void led_fx_render(LEDFx *fx, const LEDFxKernel *kernel) {
+    LEDMatrix *lm = fx->lm;
+    if (kernel->begin_frame) {
+        kernel->begin_frame(fx);
+    }
+    for (int i=0; i<lm->led_rows; i++) {
+        kernel->row(fx, i, fx->row_buf);
+
+        Diode *row = &lm->matrix[i*lm->led_cols];
+        int changed = 0;
+        for (int j=0; j<lm->led_cols; j++) {
+            int value = fx->palette[fx->row_buf[j]];
+            changed |= row[j].value ^ value;
+            row[j].value = value;
+        }
+        if (changed) {
+            led_mark_dirty(lm, i, i + 1);
+        }
+    }
+    fx->t += fx->speed;
+}
+
+void led_fx_end(LEDFx *fx) {
+    free(fx->row_buf);
+    free(fx->state);
+    fx->row_buf = NULL;
+    fx->state = NULL;
+}
+
+/* Plasma: four sine waves going in different directions
+ * */
+static void plasma_row(const LEDFx *fx, int row, uint8_t *out) {
+    int cols = fx->lm->led_cols;
+    uint8_t t = (uint8_t)fx->t;
+    uint8_t row_wave = sin_table[(uint8_t)(row*11 - t)];
+    for (int j=0; j<cols; j++) {
+        unsigned sum = sin_table[(uint8_t)(j*9 + t)]
+                     + row_wave
+                     + sin_table[(uint8_t)((row + j)*6 + (t >> 1))]
+                     + sin_table[(uint8_t)((j - row)*5 + 2*t)];
+        out[j] = (uint8_t)(sum >> 2);
+    }
+}
+
+/* Fire: sparks on the bottom row, heat rises and cools down.
+ *       fx->state holds the heat of each LED.
+ * */
+static void fire_begin_frame(LEDFx *fx) {
+    int rows = fx->lm->led_rows;
+    int cols = fx->lm->led_cols;
+    uint8_t *heat = fx->state;
+
+    // Every row takes a weighted average of the three cells below it, minus cooling
+    for (int i=0; i<rows-1; i++) {
+        uint8_t *cur = heat + i*cols;
+        const uint8_t *below = heat + (i+1)*cols;
+        for (int j=0; j<cols; j++) {
+            unsigned left = below[j > 0 ? j-1 : j];
+            unsigned right = below[j < cols-1 ? j+1 : j];
+            unsigned avg = (left + 2*below[j] + right) >> 2;
+            unsigned cooling = led_fx_hash8(fx->seed, j, i, fx->t) >> 5; // 0..7
+            cur[j] = avg > cooling ? (uint8_t)(avg - cooling) : 0;
+        }
+    }
+    // New sparks
+    uint8_t *bottom = heat + (rows-1)*cols;
+    for (int j=0; j<cols; j++) {
+        uint8_t spark = led_fx_hash8(fx->seed, j, rows, fx->t);
+        bottom[j] = spark > 96 ? 255 : spark;
+    }
+}
+
+static void fire_row(const LEDFx *fx, int row, uint8_t *out) {
+    memcpy(out, fx->state + row*fx->lm->led_cols, fx->lm->led_cols);
+}
+
+/* Value noise: random values on a lattice of 8x8 LEDs and 64 time steps,
+ *              interpolated in fixed point.
+ * */
+static void noise_row(const LEDFx *fx, int row, uint8_t *out) {
+    int cols = fx->lm->led_cols;
+    int y = row >> 3;
+    unsigned fy = (row & 7) << 5;       // 0..224, in 1/256ths
+    int z = fx->t >> 6;
+    unsigned fz = (fx->t & 63) << 2;
+    for (int j=0; j<cols; j++) {
+        int x = j >> 3;
+        unsigned fx_ = (j & 7) << 5;
+        unsigned corners[2];
+        for (int k=0; k<2; k++) {
+            unsigned top = led_fx_hash8(fx->seed, x, y, z+k)*(256-fx_) + led_fx_hash8(fx->seed, x+1, y, z+k)*fx_;
+            unsigned bot = led_fx_hash8(fx->seed, x, y+1, z+k)*(256-fx_) + led_fx_hash8(fx->seed, x+1, y+1, z+k)*fx_;
+            corners[k] = (top*(256-fy) + bot*fy) >> 16;
+        }
+        out[j] = (uint8_t)((corners[0]*(256-fz) + corners[1]*fz) >> 8);
+    }
+}
+
+/* Gradient: a diagonal ramp scrolling with time
+ * */
+static void gradient_row(const LEDFx *fx, int row, uint8_t *out) {
+    LEDMatrix *lm = fx->lm;
+    int span = lm->led_rows + lm->led_cols;
+    unsigned step = (256u << 8)/span;      // 8.8 fixed point
+    unsigned base = row*step + ((fx->t & 255) << 8);
+    for (int j=0; j<lm->led_cols; j++) {
+        out[j] = (uint8_t)((base + j*step) >> 8);
+    }
+}
+
+const LEDFxKernel led_fx_plasma = {NULL, plasma_row};
+const LEDFxKernel led_fx_fire = {fire_begin_frame, fire_row};
+const LEDFxKernel led_fx_noise = {NULL, noise_row};
+const LEDFxKernel led_fx_gradient = {NULL, gradient_row};
@@ -0,0 +1,115 @@
+/*
+ * This file is part of LEDCurses.
+ *
+ * LEDCurses is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LEDCurses is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LEDCurses.  If not, see <https://www.gnu.org/licenses/>.
+ * */
+
+#include "ledgrid.h"
+
+#define GRID_WORD(cell) ((cell) >> 6)
+#define GRID_BIT(cell) ((uint64_t)1 << ((cell) & 63))
+
+int led_grid_init(LEDGrid *grid, LEDMatrix *lm) {
+    if (!grid || !lm) {
+        return 1;
+    }
+    grid->rows = lm->led_rows;
+    grid->cols = lm->led_cols;
+
+    int n_cells = grid->rows*grid->cols;
+    int n_words = (n_cells + 63)/64;
+    grid->bits = (uint64_t*)calloc(n_words ? n_words : 1, sizeof(uint64_t));
+    grid->free_cells = (int*)calloc(n_cells ? n_cells : 1, sizeof(int));
+    grid->free_pos = (int*)calloc(n_cells ? n_cells : 1, sizeof(int));
+    if (!grid->bits || !grid->free_cells || !grid->free_pos) {
+        err(lm, "Couldn't allocate LED grid\n");
+        led_grid_end(grid);
+        return 1;
+    }
+
+    led_grid_reset(grid);
+    return 0;
+}
+
+void led_grid_reset(LEDGrid *grid) {
+    int n_cells = grid->rows*grid->cols;
+    for (int w=0; w<(n_cells + 63)/64; w++) {
+        grid->bits[w] = 0;
+    }
+    for (int cell=0; cell<n_cells; cell++) {
+        grid->free_cells[cell] = cell;
+        grid->free_pos[cell] = cell;
+    }
+    grid->n_free = n_cells;
+}
+
+int led_grid_test(LEDGrid *grid, int row, int col) {
+    if (row < 0 || row >= grid->rows || col < 0 || col >= grid->cols) {
+        return 1;
+    }
+    int cell = row*grid->cols + col;
+    return (grid->bits[GRID_WORD(cell)] & GRID_BIT(cell)) != 0;
+}
+
+void led_grid_set(LEDGrid *grid, int row, int col) {
+    if (led_grid_test(grid, row, col)) {
+        return;
+    }
+    int cell = row*grid->cols + col;
+    grid->bits[GRID_WORD(cell)] |= GRID_BIT(cell);
+
+    // Swap-remove from the free list: the last free cell takes our place
+    int pos = grid->free_pos[cell];
+    int last = grid->free_cells[--grid->n_free];
+    grid->free_cells[pos] = last;
+    grid->free_pos[last] = pos;
+    grid->free_pos[cell] = -1;
+}
+
+void led_grid_clear(LEDGrid *grid, int row, int col) {
+    if (row < 0 || row >= grid->rows || col < 0 || col >= grid->cols) {
+        return;
+    }
+    int cell = row*grid->cols + col;
+    if (!(grid->bits[GRID_WORD(cell)] & GRID_BIT(cell))) {
+        return;
+    }
+    grid->bits[GRID_WORD(cell)] &= ~GRID_BIT(cell);
+    grid->free_pos[cell] = grid->n_free;
+    grid->free_cells[grid->n_free++] = cell;
+}
+
+int led_grid_count_free(LEDGrid *grid) {
+    return grid->n_free;
+}
+
+int led_grid_sample_free(LEDGrid *grid, int *row, int *col) {
+    if (grid->n_free == 0) {
+        return 1;
+    }
+    int cell = grid->free_cells[rand() % grid->n_free];
+    *row = cell / grid->cols;
+    *col = cell % grid->cols;
+    return 0;
+}
+
+void led_grid_end(LEDGrid *grid) {
+    free(grid->bits);
+    free(grid->free_cells);
+    free(grid->free_pos);
+    grid->bits = NULL;
+    grid->free_cells = NULL;
+    grid->free_pos = NULL;
+    grid->n_free = 0;
+}
@@ -0,0 +1,204 @@
+/*
+ * This file is part of LEDCurses.
+ *
+ * LEDCurses is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LEDCurses is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LEDCurses.  If not, see <https://www.gnu.org/licenses/>.
+ * */
+
+#include <string.h> // memcpy
+#include "ledhistory.h"
+
+static LEDRowBlock *new_block(LEDHistory *history) {
+    LEDRowBlock *block = history->free_blocks;
+    if (block) {
+        history->free_blocks = block->next_free;
+    } else {
+        block = (LEDRowBlock*)malloc(sizeof(LEDRowBlock) +
+                                     history->lm->led_cols*sizeof(Diode));
+        if (!block) {
+            return NULL;
+        }
+    }
+    block->refs = 1;
+    history->n_blocks++;
+    return block;
+}
+
+static void release_block(LEDHistory *history, LEDRowBlock *block) {
+    if (block && --block->refs == 0) {
+        block->next_free = history->free_blocks;
+        history->free_blocks = block;
+        history->n_blocks--;
+    }
+}
+
+static void release_snapshot(LEDHistory *history, LEDSnapshot *snapshot) {
+    for (int i=0; i<history->lm->led_rows; i++) {
+        release_block(history, snapshot->rows[i]);
+        snapshot->rows[i] = NULL;
+    }
+}
+
+int led_history_init(LEDHistory *history, LEDMatrix *lm, int max_snapshots) {
+    if (!history || !lm || max_snapshots <= 0) {
+        return 1;
+    }
+    if (!lm->matrix) {
+        err(lm, "History needs a Diode matrix, not a mono one\n");
+        return 1;
+    }
+    history->lm = lm;
+    history->max_snapshots = max_snapshots;
+    history->n_snapshots = 0;
+    history->oldest = 0;
+    history->next_id = 1;
+    history->free_blocks = NULL;
+    history->n_blocks = 0;
+    history->ring = (LEDSnapshot*)calloc(max_snapshots, sizeof(LEDSnapshot));
+    // One array of row pointers for the current rows and each snapshot
+    history->current = (LEDRowBlock**)calloc((size_t)(max_snapshots + 1)*lm->led_rows + 1,
+                                             sizeof(LEDRowBlock*));
+    if (!history->ring || !history->current) {
+        free(history->ring);
+        free(history->current);
+        err(lm, "Couldn't allocate history\n");
+        return 1;
+    }
+    for (int s=0; s<max_snapshots; s++) {
+        history->ring[s].rows = history->current + (size_t)(s + 1)*lm->led_rows;
+    }
+    // The first snapshot copies every row
+    memset(lm->changed_rows, 1, lm->led_rows);
+    return 0;
+}
+
+uint64_t led_history_take(LEDHistory *history) {
+    LEDMatrix *lm = history->lm;
+    size_t row_size = lm->led_cols*sizeof(Diode);
+
+    // Copy the changed rows first: failing halfway leaves the snapshots as they were
+    for (int i=0; i<lm->led_rows; i++) {
+        if (!lm->changed_rows[i] && history->current[i]) {
+            continue;
+        }
+        LEDRowBlock *block = new_block(history);
+        if (!block) {
+            err(lm, "Couldn't allocate snapshot row\n");
+            return 0;
+        }
+        memcpy(block->diodes, &lm->matrix[i*lm->led_cols], row_size);
+        release_block(history, history->current[i]);
+        history->current[i] = block;
+        lm->changed_rows[i] = 0;
+    }
+
+    LEDSnapshot *snapshot;
+    if (history->n_snapshots == history->max_snapshots) {
+        snapshot = &history->ring[history->oldest];
+        release_snapshot(history, snapshot);
+        history->oldest = (history->oldest + 1) % history->max_snapshots;
+    } else {
+        snapshot = &history->ring[(history->oldest + history->n_snapshots) % history->max_snapshots];
+        history->n_snapshots++;
+    }
+    for (int i=0; i<lm->led_rows; i++) {
+        snapshot->rows[i] = history->current[i];
+        snapshot->rows[i]->refs++;
+    }
+    snapshot->id = history->next_id++;
+    return snapshot->id;
+}
+
+/* Ring index of snapshot `id`, or -1 if it's gone (or never was).
+ * Ids grow along the ring, but rewinds leave gaps: binary search.
+ * */
+static int find_snapshot(LEDHistory *history, uint64_t id) {
+    int low = 0, high = history->n_snapshots - 1;
+    while (low <= high) {
+        int mid = (low + high)/2;
+        int s = (history->oldest + mid) % history->max_snapshots;
+        if (history->ring[s].id == id) {
+            return s;
+        } else if (history->ring[s].id < id) {
+            low = mid + 1;
+        } else {
+            high = mid - 1;
+        }
+    }
+    return -1;
+}
+
+int led_history_slot(LEDHistory *history, uint64_t id) {
+    return find_snapshot(history, id);
+}
+
+int led_history_restore(LEDHistory *history, uint64_t id) {
+    int s = find_snapshot(history, id);
+    if (s < 0) {
+        return 1;
+    }
+    LEDMatrix *lm = history->lm;
+    LEDSnapshot *snapshot = &history->ring[s];
+    size_t row_size = lm->led_cols*sizeof(Diode);
+    for (int i=0; i<lm->led_rows; i++) {
+        LEDRowBlock *block = snapshot->rows[i];
+        // Same block and untouched since: the row is already there
+        if (block == history->current[i] && !lm->changed_rows[i]) {
+            continue;
+        }
+        memcpy(&lm->matrix[i*lm->led_cols], block->diodes, row_size);
+        block->refs++;
+        release_block(history, history->current[i]);
+        history->current[i] = block;
+        lm->changed_rows[i] = 0;
+        lm->dirty_rows[i] = 1;
+        if (lm->trace) led_trace_mutation(lm->trace);
+    }
+    return 0;
+}
+
+uint64_t led_history_rewind(LEDHistory *history, int steps) {
+    if (steps < 0 || steps >= history->n_snapshots) {
+        return 0;
+    }
+    // Forget what came after it
+    for (; steps > 0; steps--) {
+        int newest = (history->oldest + history->n_snapshots - 1) % history->max_snapshots;
+        release_snapshot(history, &history->ring[newest]);
+        history->n_snapshots--;
+    }
+    uint64_t id = history->ring[(history->oldest + history->n_snapshots - 1) % history->max_snapshots].id;
+    led_history_restore(history, id);
+    return id;
+}
+
+void led_history_end(LEDHistory *history) {
+    while (history->n_snapshots) {
+        release_snapshot(history, &history->ring[history->oldest]);
+        history->oldest = (history->oldest + 1) % history->max_snapshots;
+        history->n_snapshots--;
+    }
+    for (int i=0; i<history->lm->led_rows; i++) {
+        release_block(history, history->current[i]);
+        history->current[i] = NULL;
+    }
+    while (history->free_blocks) {
+        LEDRowBlock *next = history->free_blocks->next_free;
+        free(history->free_blocks);
+        history->free_blocks = next;
+    }
+    free(history->ring);
+    free(history->current);
+    history->ring = NULL;
+    history->current = NULL;
+}
@@ -0,0 +1,201 @@
+/*
+ * This file is part of LEDCurses.
+ *
+ * LEDCurses is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LEDCurses is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LEDCurses.  If not, see <https://www.gnu.org/licenses/>.
+ * */
+
+#include <ctype.h>
+#include <string.h>
+#include "ledlife.h"
+
+int led_life_init(LEDLife *life, LEDMono *mono, const char *rule) {
+    if (!life || !mono) {
+        return 1;
+    }
+    life->mono = mono;
+    life->generation = 0;
+    life->wrap = 0;
+    life->birth = 0;
+    life->survive = 0;
+    life->next = (uint64_t*)calloc((size_t)mono->rows*mono->words_per_row, sizeof(uint64_t));
+    if (!life->next) {
+        err(mono->lm, "Couldn't allocate automaton\n");
+        return 1;
+    }
+    if (led_life_set_rule(life, rule)) {
+        led_life_end(life);
+        return 1;
+    }
+    return 0;
+}
+
+int led_life_set_rule(LEDLife *life, const char *rule) {
+    uint16_t masks[2] = {0, 0};
+    int which = -1; // 0: birth, 1: survive
+    for (const char *p = rule; *p; p++) {
+        int c = toupper((unsigned char)*p);
+        if (c == 'B') {
+            which = 0;
+        } else if (c == 'S') {
+            which = 1;
+        } else if (c >= '0' && c <= '8' && which >= 0) {
+            masks[which] |= 1 << (c - '0');
+        } else if (c != '/') {
+            return 1;
+        }
+    }
+    if (which < 0) {
+        return 1;
+    }
+    life->birth = masks[0];
+    life->survive = masks[1];
+    return 0;
+}
+
+void led_life_randomize(LEDLife *life, int percent) {
+    LEDMono *mono = life->mono;
+    for (int i=0; i<mono->rows; i++) {
+        for (int j=0; j<mono->cols; j++) {
+            if (rand() % 100 < percent) {
+                led_mono_set(mono, i, j);
+            } else {
+                led_mono_clear(mono, i, j);
+            }
+        }
+    }
+}
+
+/* Neighbours to the west (bit j holds column j-1) and east (column j+1) of
+ * word w of `row`. Past the edges there is `west_in`/`east_in`.
+ * */
+static inline uint64_t west(const uint64_t *row, int w, uint64_t west_in) {
+    return (row[w] << 1) | (w ? row[w-1] >> 63 : west_in);
+}
+
+static inline uint64_t east(const uint64_t *row, int w, int last, int last_bit, uint64_t east_in) {
+    uint64_t x = row[w] >> 1;
+    if (w < last) {
+        return x | (row[w+1] << 63);
+    }
+    return x | (east_in << last_bit);
+}
+
+/* Full adder of 64 one-bit numbers at once
+ * */
+#define FULL_ADD(sum, carry, a, b, c) do { \
+        uint64_t _t = (a) ^ (b); \
+        sum = _t ^ (c); \
+        carry = ((a) & (b)) | (_t & (c)); \
+    } while (0)
+
+void led_life_step(LEDLife *life) {
+    LEDMono *mono = life->mono;
+    int rows = mono->rows, cols = mono->cols, n_words = mono->words_per_row;
+    if (!rows || !cols) {
+        return;
+    }
+    int last = n_words - 1;
+    int last_bit = (cols - 1) & 63;
+    uint64_t tail_mask = (cols & 63) ? ((uint64_t)1 << (cols & 63)) - 1 : ~(uint64_t)0;
+
+    // Masks of the counts that matter, precomputed once per step
+    int counts[9], n_counts = 0;
+    for (int n=0; n<=8; n++) {
+        if (((life->birth | life->survive) >> n) & 1) {
+            counts[n_counts++] = n;
+        }
+    }
+
+    for (int i=0; i<rows; i++) {
+        const uint64_t *cur = mono->bits + i*n_words;
+        const uint64_t *up, *down;
+        if (i > 0) up = cur - n_words;
+        else up = life->wrap ? mono->bits + (rows-1)*n_words : NULL;
+        if (i < rows-1) down = cur + n_words;
+        else down = life->wrap ? mono->bits : NULL;
+        uint64_t *out = life->next + i*n_words;
+
+        // Bits coming in from the opposite edge
+        uint64_t up_west = 0, up_east = 0, cur_west = 0, cur_east = 0, down_west = 0, down_east = 0;
+        if (life->wrap) {
+            cur_west = (cur[last] >> last_bit) & 1;
+            cur_east = cur[0] & 1;
+            if (up) {
+                up_west = (up[last] >> last_bit) & 1;
+                up_east = up[0] & 1;
+            }
+            if (down) {
+                down_west = (down[last] >> last_bit) & 1;
+                down_east = down[0] & 1;
+            }
+        }
+
+        for (int w=0; w<n_words; w++) {
+            uint64_t n0 = 0, n1 = 0, n2 = 0, n5 = 0, n6 = 0, n7 = 0;
+            if (up) {
+                n0 = west(up, w, up_west);
+                n1 = up[w];
+                n2 = east(up, w, last, last_bit, up_east);
+            }
+            uint64_t n3 = west(cur, w, cur_west);
+            uint64_t n4 = east(cur, w, last, last_bit, cur_east);
+            if (down) {
+                n5 = west(down, w, down_west);
+                n6 = down[w];
+                n7 = east(down, w, last, last_bit, down_east);
+            }
+
+            // Carry-save adder tree: 8 one-bit inputs -> b3 b2 b1 b0
+            uint64_t sa, ca, sb, cb, b0, cd, t, ce, b1, cf;
+            FULL_ADD(sa, ca, n0, n1, n2);
+            FULL_ADD(sb, cb, n3, n4, n5);
+            uint64_t sc = n6 ^ n7, cc = n6 & n7;
+            FULL_ADD(b0, cd, sa, sb, sc);
+            FULL_ADD(t, ce, ca, cb, cc);
+            b1 = t ^ cd;
+            cf = t & cd;
+            uint64_t b2 = ce ^ cf, b3 = ce & cf;
+
+            uint64_t alive = cur[w];
+            uint64_t next = 0;
+            for (int k=0; k<n_counts; k++) {
+                int n = counts[k];
+                uint64_t eq = (n & 1 ? b0 : ~b0) & (n & 2 ? b1 : ~b1)
+                            & (n & 4 ? b2 : ~b2) & (n & 8 ? b3 : ~b3);
+                uint64_t born = (life->birth >> n) & 1 ? ~alive : 0;
+                uint64_t kept = (life->survive >> n) & 1 ? alive : 0;
+                next |= eq & (born | kept);
+            }
+            out[w] = next;
+        }
+        // Nothing lives past the last column
+        out[last] &= tail_mask;
+    }
+    memcpy(mono->bits, life->next, (size_t)rows*n_words*sizeof(uint64_t));
+    life->generation++;
+}
+
+int led_life_population(LEDLife *life) {
+    LEDMono *mono = life->mono;
+    int population = 0;
+    for (size_t w=0; w<(size_t)mono->rows*mono->words_per_row; w++) {
+        population += __builtin_popcountll(mono->bits[w]);
+    }
+    return population;
+}
+
+void led_life_end(LEDLife *life) {
+    free(life->next);
+    life->next = NULL;
+}
@@ -0,0 +1,85 @@
+/*
+ * This file is part of LEDCurses.
+ *
+ * LEDCurses is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LEDCurses is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LEDCurses.  If not, see <https://www.gnu.org/licenses/>.
+ * */
+
+#include <string.h> // memset
+#include "ledmono.h"
+
+int led_mono_init(LEDMono *mono, LEDMatrix *lm) {
+    if (!mono || !lm) {
+        return 1;
+    }
+    if (!lm->mono_bits) {
+        err(lm, "LEDMono needs a matrix from led_init_mono\n");
+        return 1;
+    }
+    mono->lm = lm;
+    mono->rows = lm->led_rows;
+    mono->cols = lm->led_cols;
+    mono->words_per_row = lm->mono_words;
+    mono->bits = lm->mono_bits;
+    mono->shown = lm->mono_shown;
+    return 0;
+}
+
+void led_mono_fill(LEDMono *mono, int on) {
+    size_t row_size = mono->words_per_row*sizeof(uint64_t);
+    if (!on) {
+        memset(mono->bits, 0, mono->rows*row_size);
+        return;
+    }
+    // Bits past the last column stay off
+    int tail = mono->cols & 63;
+    uint64_t last = tail ? ((uint64_t)1 << tail) - 1 : ~(uint64_t)0;
+    for (int i=0; i<mono->rows; i++) {
+        uint64_t *row = mono->bits + i*mono->words_per_row;
+        memset(row, 0xff, row_size);
+        row[mono->words_per_row - 1] = last;
+    }
+}
+
+int led_mono_changed(LEDMono *mono) {
+    int changed = 0;
+    size_t n_words = (size_t)mono->rows*mono->words_per_row;
+    for (size_t w=0; w<n_words; w++) {
+        changed += __builtin_popcountll(mono->bits[w] ^ mono->shown[w]);
+    }
+    return changed;
+}
+
+int led_mono_draw(LEDMono *mono) {
+    LEDMatrix *lm = mono->lm;
+    int changed = 0;
+    for (int i=0; i<mono->rows; i++) {
+        const uint64_t *bits = mono->bits + i*mono->words_per_row;
+        const uint64_t *shown = mono->shown + i*mono->words_per_row;
+        int row_changed = 0;
+        for (int w=0; w<mono->words_per_row; w++) {
+            row_changed += __builtin_popcountll(bits[w] ^ shown[w]);
+        }
+        if (row_changed) {
+            led_mark_dirty(lm, i, i + 1);
+            changed += row_changed;
+        }
+    }
+    led_draw(lm);
+    return changed;
+}
+
+void led_mono_end(LEDMono *mono) {
+    mono->bits = NULL;
+    mono->shown = NULL;
+}
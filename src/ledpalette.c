@@ -0,0 +1,90 @@
+/*
+ * This file is part of LEDCurses.
+ *
+ * LEDCurses is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LEDCurses is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LEDCurses.  If not, see <https://www.gnu.org/licenses/>.
+ * */
+
+#include "ledpalette.h"
+
+int led_palette_init(LEDPalette *palette, int first_pair, int n_pairs) {
+    if (!palette || first_pair < 1 || n_pairs < 1 || first_pair + n_pairs > COLOR_PAIRS) {
+        return 1;
+    }
+    palette->first_pair = first_pair;
+    palette->n_pairs = n_pairs;
+    palette->offset = 0;
+    palette->slot_fg = (short*)malloc(4*n_pairs*sizeof(short));
+    if (!palette->slot_fg) {
+        return 1;
+    }
+    palette->slot_bg = palette->slot_fg + n_pairs;
+    palette->shown_fg = palette->slot_bg + n_pairs;
+    palette->shown_bg = palette->shown_fg + n_pairs;
+    for (int i=0; i<n_pairs; i++) {
+        palette->slot_fg[i] = COLOR_WHITE;
+        palette->slot_bg[i] = COLOR_BLACK;
+        palette->shown_fg[i] = -2;
+        palette->shown_bg[i] = -2;
+    }
+    return 0;
+}
+
+void led_palette_set(LEDPalette *palette, int index, short fg, short bg) {
+    if (index < 0 || index >= palette->n_pairs) {
+        return;
+    }
+    palette->slot_fg[index] = fg;
+    palette->slot_bg[index] = bg;
+}
+
+void led_palette_rotate(LEDPalette *palette, int steps) {
+    int n = palette->n_pairs;
+    palette->offset = ((palette->offset + steps) % n + n) % n;
+}
+
+int led_palette_set_rgb(short color, short r, short g, short b) {
+    if (!can_change_color()) {
+        return 1;
+    }
+    return init_color(color, r, g, b) == ERR;
+}
+
+int led_palette_apply(LEDPalette *palette) {
+    int redefined = 0;
+    for (int i=0; i<palette->n_pairs; i++) {
+        int slot = (i + palette->offset) % palette->n_pairs;
+        short fg = palette->slot_fg[slot];
+        short bg = palette->slot_bg[slot];
+        if (fg == palette->shown_fg[i] && bg == palette->shown_bg[i]) {
+            continue;
+        }
+        // ncurses marks the cells using this pair as changed
+        init_pair(palette->first_pair + i, fg, bg);
+        palette->shown_fg[i] = fg;
+        palette->shown_bg[i] = bg;
+        redefined++;
+    }
+    if (redefined) {
+        doupdate();
+    }
+    return redefined;
+}
+
+void led_palette_end(LEDPalette *palette) {
+    free(palette->slot_fg);
+    palette->slot_fg = NULL;
+    palette->slot_bg = NULL;
+    palette->shown_fg = NULL;
+    palette->shown_bg = NULL;
+}
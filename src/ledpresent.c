@@ -0,0 +1,233 @@
+/*
+ * This file is part of LEDCurses.
+ *
+ * LEDCurses is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LEDCurses is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LEDCurses.  If not, see <https://www.gnu.org/licenses/>.
+ * */
+
+#include <string.h> // memcpy, memset
+#include <time.h>
+#include "ledpresent.h"
+
+/* read_keys: moves the pending keys from ncurses to the queue.
+ * */
+static void read_keys(LEDPresenter *presenter) {
+    if (!presenter->view.win) {
+        return;
+    }
+    int key;
+    while ((key = wgetch(presenter->view.win)) != ERR) {
+        pthread_mutex_lock(&presenter->lock);
+        if (presenter->n_keys < LED_PRESENT_KEYS) {
+            int tail = (presenter->key_head + presenter->n_keys) % LED_PRESENT_KEYS;
+            presenter->keys[tail] = key;
+            presenter->n_keys++;
+        }
+        pthread_cond_signal(&presenter->key_cv);
+        pthread_mutex_unlock(&presenter->lock);
+    }
+}
+
+/* Bytes of the LED state copied into each frame: the Diodes or the mono bits.
+ * */
+static size_t leds_size(LEDMatrix *lm) {
+    if (lm->mono_bits) {
+        return (size_t)lm->led_rows*lm->mono_words*sizeof(uint64_t);
+    }
+    return (size_t)lm->led_rows*lm->led_cols*sizeof(Diode);
+}
+
+static void present_ready(LEDPresenter *presenter) {
+    // Called with the lock held, returns with it held
+    int tmp = presenter->front;
+    presenter->front = presenter->ready;
+    presenter->ready = tmp;
+    presenter->fresh = 0;
+    pthread_mutex_unlock(&presenter->lock);
+
+    LEDFrame *front = &presenter->frames[presenter->front];
+    presenter->view.matrix = front->matrix;
+    presenter->view.mono_bits = front->mono_bits;
+    presenter->view.dirty_rows = front->dirty_rows;
+    led_draw(&presenter->view); // clears front->dirty_rows
+
+    pthread_mutex_lock(&presenter->lock);
+    presenter->n_presented++;
+}
+
+static void *presenter_thread(void *arg) {
+    LEDPresenter *presenter = (LEDPresenter*)arg;
+    pthread_mutex_lock(&presenter->lock);
+    while (!presenter->quit) {
+        if (presenter->fresh) {
+            present_ready(presenter);
+        }
+        pthread_mutex_unlock(&presenter->lock);
+        read_keys(presenter);
+        pthread_mutex_lock(&presenter->lock);
+
+        if (!presenter->fresh && !presenter->quit) {
+            struct timespec until;
+            clock_gettime(CLOCK_REALTIME, &until);
+            until.tv_nsec += LED_PRESENT_POLL_MS*1000000L;
+            if (until.tv_nsec >= 1000000000L) {
+                until.tv_sec++;
+                until.tv_nsec -= 1000000000L;
+            }
+            pthread_cond_timedwait(&presenter->frame_cv, &presenter->lock, &until);
+        }
+    }
+    pthread_mutex_unlock(&presenter->lock);
+    return NULL;
+}
+
+int led_presenter_start(LEDPresenter *presenter, LEDMatrix *lm) {
+    if (!presenter || !lm || lm->trace || lm->sim || lm->quality) {
+        return 1;
+    }
+    size_t matrix_size = (leds_size(lm) + 15) & ~(size_t)15;
+    size_t frame_size = matrix_size + ((lm->led_rows + 15) & ~15);
+    // Mono matrices: plus the bits the view last rasterized
+    presenter->mem = malloc(3*frame_size + (lm->mono_bits ? leds_size(lm) : 0));
+    if (!presenter->mem) {
+        err(lm, "Couldn't allocate presenter frames\n");
+        return 1;
+    }
+    for (int f=0; f<3; f++) {
+        char *frame = (char*)presenter->mem + f*frame_size;
+        presenter->frames[f].matrix = lm->matrix ? (Diode*)frame : NULL;
+        presenter->frames[f].mono_bits = lm->matrix ? NULL : (uint64_t*)frame;
+        presenter->frames[f].dirty_rows = (unsigned char*)(frame + matrix_size);
+        memcpy(frame, lm->matrix ? (void*)lm->matrix : (void*)lm->mono_bits, leds_size(lm));
+        memset(presenter->frames[f].dirty_rows, 0, lm->led_rows);
+    }
+    presenter->back = 0;
+    presenter->ready = 1;
+    presenter->front = 2;
+    presenter->key_head = 0;
+    presenter->n_keys = 0;
+    presenter->n_published = 0;
+    presenter->n_presented = 0;
+    presenter->n_dropped = 0;
+    presenter->fresh = 0;
+    presenter->quit = 0;
+    presenter->lm = lm;
+
+    // The view shares the window and cell buffers, which only the presenter
+    // thread touches from now on, but reads its own frames
+    presenter->view = *lm;
+    presenter->view.raster_pool = NULL; // its workers would read lm->matrix
+    presenter->view.presenter = NULL;
+    presenter->view.quality = NULL;
+    if (lm->mono_bits) {
+        presenter->view.mono_shown = (uint64_t*)((char*)presenter->mem + 3*frame_size);
+        memcpy(presenter->view.mono_shown, lm->mono_shown, leds_size(lm));
+    }
+    presenter->blocking = lm->win && !is_nodelay(lm->win);
+    if (lm->win) {
+        nodelay(lm->win, TRUE);
+    }
+
+    pthread_mutex_init(&presenter->lock, NULL);
+    pthread_cond_init(&presenter->frame_cv, NULL);
+    pthread_cond_init(&presenter->key_cv, NULL);
+    if (pthread_create(&presenter->thread, NULL, presenter_thread, presenter)) {
+        err(lm, "Couldn't start presenter thread\n");
+        pthread_mutex_destroy(&presenter->lock);
+        pthread_cond_destroy(&presenter->frame_cv);
+        pthread_cond_destroy(&presenter->key_cv);
+        free(presenter->mem);
+        presenter->mem = NULL;
+        return 1;
+    }
+    lm->presenter = presenter;
+    return 0;
+}
+
+void led_presenter_publish(LEDPresenter *presenter) {
+    LEDMatrix *lm = presenter->lm;
+    LEDFrame *back = &presenter->frames[presenter->back];
+    // The back buffer belongs to this thread: no lock needed to fill it
+    if (lm->matrix) {
+        memcpy(back->matrix, lm->matrix, leds_size(lm));
+    } else {
+        memcpy(back->mono_bits, lm->mono_bits, leds_size(lm));
+        memcpy(lm->mono_shown, lm->mono_bits, leds_size(lm));
+    }
+    memcpy(back->dirty_rows, lm->dirty_rows, lm->led_rows);
+    memset(lm->dirty_rows, 0, lm->led_rows);
+
+    pthread_mutex_lock(&presenter->lock);
+    if (presenter->fresh) {
+        // The ready frame was never drawn: drop it, keeping what it changed
+        const unsigned char *dropped = presenter->frames[presenter->ready].dirty_rows;
+        for (int i=0; i<lm->led_rows; i++) {
+            back->dirty_rows[i] |= dropped[i];
+        }
+        presenter->n_dropped++;
+    }
+    int tmp = presenter->ready;
+    presenter->ready = presenter->back;
+    presenter->back = tmp;
+    presenter->fresh = 1;
+    presenter->n_published++;
+    pthread_cond_signal(&presenter->frame_cv);
+    pthread_mutex_unlock(&presenter->lock);
+}
+
+int led_presenter_getch(LEDPresenter *presenter) {
+    int key = ERR;
+    pthread_mutex_lock(&presenter->lock);
+    while (presenter->blocking && !presenter->n_keys && !presenter->quit) {
+        pthread_cond_wait(&presenter->key_cv, &presenter->lock);
+    }
+    if (presenter->n_keys) {
+        key = presenter->keys[presenter->key_head];
+        presenter->key_head = (presenter->key_head + 1) % LED_PRESENT_KEYS;
+        presenter->n_keys--;
+    }
+    pthread_mutex_unlock(&presenter->lock);
+    return key;
+}
+
+void led_presenter_stop(LEDPresenter *presenter) {
+    pthread_mutex_lock(&presenter->lock);
+    presenter->quit = 1;
+    pthread_cond_signal(&presenter->frame_cv);
+    pthread_cond_broadcast(&presenter->key_cv);
+    pthread_mutex_unlock(&presenter->lock);
+    pthread_join(presenter->thread, NULL);
+
+    // Back to synchronous drawing, starting from the newest frame
+    pthread_mutex_lock(&presenter->lock);
+    if (presenter->fresh) {
+        present_ready(presenter);
+    }
+    // Keys not read yet go back to ncurses (ungetch is a stack)
+    for (int k=presenter->n_keys-1; k>=0; k--) {
+        ungetch(presenter->keys[(presenter->key_head + k) % LED_PRESENT_KEYS]);
+    }
+    presenter->n_keys = 0;
+    pthread_mutex_unlock(&presenter->lock);
+    LEDMatrix *lm = presenter->lm;
+    if (lm->win) {
+        nodelay(lm->win, !presenter->blocking);
+    }
+    lm->presenter = NULL;
+
+    pthread_mutex_destroy(&presenter->lock);
+    pthread_cond_destroy(&presenter->frame_cv);
+    pthread_cond_destroy(&presenter->key_cv);
+    free(presenter->mem);
+    presenter->mem = NULL;
+}
@@ -0,0 +1,259 @@
+/*
+ * This file is part of LEDCurses.
+ *
+ * LEDCurses is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LEDCurses is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LEDCurses.  If not, see <https://www.gnu.org/licenses/>.
+ * */
+
+#include "ledprim.h"
+
+/* span: writes a clipped span, without marking anything dirty.
+ * */
+static void span(LEDMatrix *lm, int row, int col_begin, int col_end, int value) {
+    if (row < 0 || row >= lm->led_rows || !lm->matrix) {
+        return;
+    }
+    if (col_begin > col_end) {
+        int tmp = col_begin;
+        col_begin = col_end;
+        col_end = tmp;
+    }
+    if (col_begin < 0) col_begin = 0;
+    if (col_end >= lm->led_cols) col_end = lm->led_cols - 1;
+    Diode *diode = &lm->matrix[row*lm->led_cols + col_begin];
+    for (int j=col_begin; j<=col_end; j++, diode++) {
+        diode->value = value;
+    }
+}
+
+void led_hspan(LEDMatrix *lm, int row, int col_begin, int col_end, int value) {
+    span(lm, row, col_begin, col_end, value);
+    led_mark_dirty(lm, row, row + 1);
+}
+
+static void line(LEDMatrix *lm, int row0, int col0, int row1, int col1, int value) {
+    int d_col = abs(col1 - col0), step_col = col0 < col1 ? 1 : -1;
+    int d_row = -abs(row1 - row0), step_row = row0 < row1 ? 1 : -1;
+    int error = d_col + d_row;
+    int run_begin = col0; // first column of the run on the current row
+    while (1) {
+        if (row0 == row1 && col0 == col1) {
+            break;
+        }
+        int e2 = 2*error;
+        if (e2 >= d_row) {
+            error += d_row;
+            col0 += step_col;
+        }
+        if (e2 <= d_col) {
+            // Moving to the next row: flush the run on this one
+            span(lm, row0, run_begin, col0 - (e2 >= d_row ? step_col : 0), value);
+            error += d_col;
+            row0 += step_row;
+            run_begin = col0;
+        }
+    }
+    span(lm, row0, run_begin, col0, value);
+}
+
+void led_line(LEDMatrix *lm, int row0, int col0, int row1, int col1, int value) {
+    line(lm, row0, col0, row1, col1, value);
+    led_mark_dirty(lm, row0 < row1 ? row0 : row1, (row0 < row1 ? row1 : row0) + 1);
+}
+
+void led_rect(LEDMatrix *lm, int row, int col, int rows, int cols, int value, int filled) {
+    if (rows <= 0 || cols <= 0) {
+        return;
+    }
+    int last_row = row + rows - 1, last_col = col + cols - 1;
+    for (int i=row; i<=last_row; i++) {
+        if (filled || i == row || i == last_row) {
+            span(lm, i, col, last_col, value);
+        } else {
+            span(lm, i, col, col, value);
+            span(lm, i, last_col, last_col, value);
+        }
+    }
+    led_mark_dirty(lm, row, last_row + 1);
+}
+
+void led_circle(LEDMatrix *lm, int row, int col, int radius, int value, int filled) {
+    if (radius < 0) {
+        return;
+    }
+    int x = 0, y = radius, d = 1 - radius;
+    int run_begin = 0; // first x of the run on rows row +- y
+    while (x <= y) {
+        // Rows row +- x: one diode on each side (or the span between them)
+        if (filled) {
+            span(lm, row + x, col - y, col + y, value);
+            span(lm, row - x, col - y, col + y, value);
+        } else {
+            span(lm, row + x, col - y, col - y, value);
+            span(lm, row + x, col + y, col + y, value);
+            span(lm, row - x, col - y, col - y, value);
+            span(lm, row - x, col + y, col + y, value);
+        }
+        if (d >= 0) {
+            // y decreases: rows row +- y are done, flush their runs
+            if (filled) {
+                span(lm, row + y, col - x, col + x, value);
+                span(lm, row - y, col - x, col + x, value);
+            } else {
+                span(lm, row + y, col - x, col - run_begin, value);
+                span(lm, row + y, col + run_begin, col + x, value);
+                span(lm, row - y, col - x, col - run_begin, value);
+                span(lm, row - y, col + run_begin, col + x, value);
+            }
+            d += 2*(x - y) + 5;
+            y--;
+            run_begin = x + 1;
+        } else {
+            d += 2*x + 3;
+        }
+        x++;
+    }
+    // The last run didn't see y decrease
+    if (run_begin < x) {
+        if (filled) {
+            span(lm, row + y, col - (x - 1), col + (x - 1), value);
+            span(lm, row - y, col - (x - 1), col + (x - 1), value);
+        } else {
+            span(lm, row + y, col - (x - 1), col - run_begin, value);
+            span(lm, row + y, col + run_begin, col + (x - 1), value);
+            span(lm, row - y, col - (x - 1), col - run_begin, value);
+            span(lm, row - y, col + run_begin, col + (x - 1), value);
+        }
+    }
+    led_mark_dirty(lm, row - radius, row + radius + 1);
+}
+
+int led_polygon(LEDMatrix *lm, const int *rows, const int *cols, int n, int value, int filled) {
+    if (n <= 0) {
+        return 0;
+    }
+    int min_row = rows[0], max_row = rows[0];
+    for (int k=0; k<n; k++) {
+        line(lm, rows[k], cols[k], rows[(k+1)%n], cols[(k+1)%n], value);
+        if (rows[k] < min_row) min_row = rows[k];
+        if (rows[k] > max_row) max_row = rows[k];
+    }
+
+    if (filled && n >= 3) {
+        int *crossings = (int*)malloc(n*sizeof(int));
+        if (!crossings) {
+            err(lm, "Couldn't allocate polygon crossings\n");
+            return 1;
+        }
+        int first = min_row < 0 ? 0 : min_row;
+        int last = max_row >= lm->led_rows ? lm->led_rows - 1 : max_row;
+        for (int i=first; i<=last; i++) {
+            // Columns where the edges cross the row (half open in rows, so
+            // shared vertices count once)
+            int n_crossings = 0;
+            for (int k=0; k<n; k++) {
+                int r0 = rows[k], c0 = cols[k];
+                int r1 = rows[(k+1)%n], c1 = cols[(k+1)%n];
+                if ((r0 <= i && i < r1) || (r1 <= i && i < r0)) {
+                    crossings[n_crossings++] = c0 + (int)((long)(i - r0)*(c1 - c0)/(r1 - r0));
+                }
+            }
+            // Insertion sort: there are few crossings per row
+            for (int a=1; a<n_crossings; a++) {
+                int c = crossings[a], b = a - 1;
+                for (; b >= 0 && crossings[b] > c; b--) {
+                    crossings[b+1] = crossings[b];
+                }
+                crossings[b+1] = c;
+            }
+            for (int a=0; a+1<n_crossings; a+=2) {
+                span(lm, i, crossings[a], crossings[a+1], value);
+            }
+        }
+        free(crossings);
+    }
+    led_mark_dirty(lm, min_row, max_row + 1);
+    return 0;
+}
+
+typedef struct fill_seed {
+    int row;
+    int col;
+} FillSeed;
+
+int led_flood_fill(LEDMatrix *lm, int row, int col, int value) {
+    if (!lm->matrix) {
+        return 1;
+    }
+    if (row < 0 || row >= lm->led_rows || col < 0 || col >= lm->led_cols) {
+        return 0;
+    }
+    int cols = lm->led_cols;
+    int target = lm->matrix[row*cols + col].value;
+    if (target == value) {
+        return 0;
+    }
+
+    int max_seeds = 64, n_seeds = 0;
+    FillSeed *seeds = (FillSeed*)malloc(max_seeds*sizeof(FillSeed));
+    if (!seeds) {
+        err(lm, "Couldn't allocate flood fill stack\n");
+        return 1;
+    }
+    seeds[n_seeds++] = (FillSeed){row, col};
+    int min_row = row, max_row = row;
+
+    while (n_seeds) {
+        FillSeed seed = seeds[--n_seeds];
+        Diode *line = &lm->matrix[seed.row*cols];
+        if (line[seed.col].value != target) {
+            continue; // already filled from another seed
+        }
+        // Widen the seed to its whole span, and fill it
+        int begin = seed.col, end = seed.col;
+        while (begin > 0 && line[begin-1].value == target) begin--;
+        while (end < cols-1 && line[end+1].value == target) end++;
+        span(lm, seed.row, begin, end, value);
+        if (seed.row < min_row) min_row = seed.row;
+        if (seed.row > max_row) max_row = seed.row;
+
+        // One seed per run of the target value above and below the span
+        for (int d=-1; d<=1; d+=2) {
+            int i = seed.row + d;
+            if (i < 0 || i >= lm->led_rows) {
+                continue;
+            }
+            Diode *next = &lm->matrix[i*cols];
+            for (int j=begin; j<=end; j++) {
+                if (next[j].value != target || (j > begin && next[j-1].value == target)) {
+                    continue;
+                }
+                if (n_seeds == max_seeds) {
+                    FillSeed *grown = (FillSeed*)realloc(seeds, 2*max_seeds*sizeof(FillSeed));
+                    if (!grown) {
+                        free(seeds);
+                        led_mark_dirty(lm, min_row, max_row + 1);
+                        err(lm, "Couldn't grow flood fill stack\n");
+                        return 1;
+                    }
+                    seeds = grown;
+                    max_seeds *= 2;
+                }
+                seeds[n_seeds++] = (FillSeed){i, j};
+            }
+        }
+    }
+    free(seeds);
+    led_mark_dirty(lm, min_row, max_row + 1);
+    return 0;
+}
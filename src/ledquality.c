@@ -0,0 +1,223 @@
+/*
+ * This file is part of LEDCurses.
+ *
+ * LEDCurses is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LEDCurses is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LEDCurses.  If not, see <https://www.gnu.org/licenses/>.
+ * */
+
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include "ledquality.h"
+
+#define MAX_UPGRADE_AFTER (64*LED_QUALITY_PATIENCE)
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec*1000000000ull + ts.tv_nsec;
+}
+
+/* Bytes written to the terminal but not sent yet, -1 if unknown
+ * */
+static int out_queue(LEDQuality *quality) {
+    int queued;
+    if (quality->fd < 0 || ioctl(quality->fd, TIOCOUTQ, &queued)) {
+        return -1;
+    }
+    return queued;
+}
+
+/* Updates the drain rate with a new sample of the output queue
+ * */
+static void sample_queue(LEDQuality *quality, int queued, uint64_t now) {
+    // Only exact while the queue didn't run empty
+    if (queued > 0 && quality->last_queued > queued && now > quality->last_sample_ns) {
+        double dt_ms = (now - quality->last_sample_ns)/1e6;
+        double rate = (quality->last_queued - queued)/dt_ms;
+        quality->drain_rate = quality->drain_rate > 0 ?
+                              0.8*quality->drain_rate + 0.2*rate : rate;
+    }
+    quality->last_queued = queued;
+    quality->last_sample_ns = now;
+}
+
+static double drain_ms(LEDQuality *quality, int queued) {
+    if (queued <= 0) {
+        return 0;
+    }
+    // Nothing measured yet: assume the queue takes the whole budget
+    return quality->drain_rate > 0 ? queued/quality->drain_rate : quality->budget_ms;
+}
+
+int led_quality_init(LEDQuality *quality, LEDMatrix *lm, int budget_ms) {
+    if (!quality || !lm || budget_ms <= 0) {
+        return 1;
+    }
+    if (lm->presenter) {
+        err(lm, "LEDQuality can't work with an LEDPresenter\n");
+        return 1;
+    }
+    quality->lm = lm;
+    quality->fd = lm->win ? STDOUT_FILENO : -1;
+    quality->budget_ms = budget_ms;
+    quality->level = LED_QUALITY_FULL;
+    quality->full_size = lm->led_size;
+    quality->full_edge_on = lm->ch_edge_on;
+    quality->full_edge_off = lm->ch_edge_off;
+    // Each level after the flat one shrinks by 2, down to size 1
+    quality->max_level = LED_QUALITY_FLAT + (lm->led_size > 1 ? (lm->led_size - 1)/2 : 0);
+    quality->drain_rate = 0;
+    quality->latency_ms = 0;
+    quality->last_queued = -1;
+    quality->last_sample_ns = 0;
+    quality->queued_before = 0;
+    quality->over = 0;
+    quality->under = 0;
+    quality->upgrade_after = 4*LED_QUALITY_PATIENCE;
+    quality->last_change = 0;
+    quality->n_frames = 0;
+    quality->n_skipped = 0;
+    quality->n_bytes = 0;
+    quality->last_bytes = 0;
+    quality->last_cells = 0;
+    quality->pending = 0;
+    quality->force = 0;
+    lm->quality = quality;
+    return 0;
+}
+
+void led_quality_set_level(LEDQuality *quality, int level) {
+    LEDMatrix *lm = quality->lm;
+    if (level < LED_QUALITY_FULL) level = LED_QUALITY_FULL;
+    if (level > quality->max_level) level = quality->max_level;
+
+    int size = level > LED_QUALITY_FLAT ? quality->full_size - 2*(level - LED_QUALITY_FLAT)
+                                        : quality->full_size;
+    if (lm->led_size != size) {
+        led_set_led_size(lm, size);
+    }
+
+    chtype edge_on = level >= LED_QUALITY_FLAT ? lm->ch_inner_on : quality->full_edge_on;
+    chtype edge_off = level >= LED_QUALITY_FLAT ? lm->ch_inner_off : quality->full_edge_off;
+    if (lm->ch_edge_on != edge_on || lm->ch_edge_off != edge_off) {
+        lm->ch_edge_on = edge_on;
+        lm->ch_edge_off = edge_off;
+        led_mark_dirty(lm, 0, lm->led_rows);
+    }
+    quality->level = level;
+    quality->last_change = quality->n_frames;
+    quality->over = 0;
+    quality->under = 0;
+}
+
+int led_quality_skip(LEDQuality *quality) {
+    uint64_t now = now_ns();
+    int queued = out_queue(quality);
+    sample_queue(quality, queued, now);
+
+    // The terminal is still busy with previous frames: either its queue
+    // needs too long to drain, or it can't even take more (ptys don't
+    // report a queue, writing to them just blocks)
+    struct pollfd pfd = {.fd = quality->fd, .events = POLLOUT};
+    int full = quality->fd >= 0 && poll(&pfd, 1, 0) == 0;
+    if (!quality->force && (full || drain_ms(quality, queued) > quality->budget_ms)) {
+        quality->n_skipped++;
+        quality->pending = 1;
+        return 1;
+    }
+    quality->pending = 0;
+    quality->frame_begin_ns = now;
+    quality->queued_before = queued > 0 ? queued : 0;
+    return 0;
+}
+
+void led_quality_frame_done(LEDQuality *quality, int n_cells) {
+    uint64_t now = now_ns();
+    int queued = out_queue(quality);
+    double write_ms = (now - quality->frame_begin_ns)/1e6;
+
+    // What the frame added to the queue, plus what drained while writing
+    int bytes = 0;
+    if (queued >= 0) {
+        bytes = queued - quality->queued_before + (int)(quality->drain_rate*write_ms);
+        if (bytes < 0) bytes = 0;
+    }
+    quality->last_bytes = bytes;
+    quality->last_cells = n_cells;
+    quality->n_bytes += bytes;
+    quality->n_frames++;
+    quality->last_queued = queued;
+    quality->last_sample_ns = now;
+
+    double latency = write_ms + drain_ms(quality, queued);
+    quality->latency_ms = quality->n_frames > 1 ? 0.8*quality->latency_ms + 0.2*latency : latency;
+
+    if (quality->latency_ms > quality->budget_ms) {
+        quality->under = 0;
+        // Way over budget: don't wait for a slow link to go through more frames
+        int severe = latency > 4*quality->budget_ms &&
+                     quality->n_frames - quality->last_change > 1;
+        if ((++quality->over >= LED_QUALITY_PATIENCE || severe) &&
+            quality->level < quality->max_level) {
+            // Going up didn't last: wait longer before trying again
+            if (quality->n_frames - quality->last_change < (uint64_t)quality->upgrade_after &&
+                quality->upgrade_after < MAX_UPGRADE_AFTER) {
+                quality->upgrade_after *= 2;
+            }
+            led_quality_set_level(quality, quality->level + 1);
+        }
+    } else if (quality->latency_ms < quality->budget_ms/4.0) {
+        quality->over = 0;
+        if (++quality->under >= quality->upgrade_after && quality->level > LED_QUALITY_FULL) {
+            led_quality_set_level(quality, quality->level - 1);
+        }
+    } else {
+        quality->over = 0;
+        quality->under = 0;
+    }
+}
+
+void led_quality_flush(LEDQuality *quality, int force) {
+    if (!quality->pending) {
+        return;
+    }
+    quality->force = force ? 1 : 0;
+    led_draw(quality->lm);
+    quality->force = 0;
+}
+
+int led_quality_napms(LEDQuality *quality, int ms) {
+    uint64_t end = now_ns() + (uint64_t)(ms > 0 ? ms : 0)*1000000ull;
+    led_quality_flush(quality, 0);
+    for (;;) {
+        uint64_t now = now_ns();
+        if (now >= end) {
+            return OK;
+        }
+        int left = (int)((end - now + 999999)/1000000);
+        if (!quality->pending) {
+            return napms(left);
+        }
+        napms(left < LED_QUALITY_RETRY_MS ? left : LED_QUALITY_RETRY_MS);
+        led_quality_flush(quality, 0);
+    }
+}
+
+void led_quality_end(LEDQuality *quality) {
+    led_quality_flush(quality, 1);
+    led_quality_set_level(quality, LED_QUALITY_FULL);
+    quality->lm->quality = NULL;
+}
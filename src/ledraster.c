@@ -0,0 +1,146 @@
+/*
+ * This file is part of LEDCurses.
+ *
+ * LEDCurses is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LEDCurses is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LEDCurses.  If not, see <https://www.gnu.org/licenses/>.
+ * */
+
+#include <pthread.h>
+#include "ledraster.h"
+
+struct led_raster_pool {
+    LEDMatrix *lm;
+    pthread_t *threads;
+    int n_threads;          // bands per run, the caller's one included
+    int n_started;          // workers actually running
+    pthread_mutex_t lock;
+    pthread_cond_t work_cv;
+    pthread_cond_t done_cv;
+    unsigned long generation; // bumped on each run
+    int pending;              // bands still being rasterized
+    int quit;
+};
+
+typedef struct raster_worker_arg {
+    LEDRasterPool *pool;
+    int band;
+} RasterWorkerArg;
+
+static void raster_band(LEDRasterPool *pool, int band) {
+    int rows = pool->lm->led_rows;
+    int row_begin = (int)((long)rows*band/pool->n_threads);
+    int row_end = (int)((long)rows*(band+1)/pool->n_threads);
+    led_raster_rows(pool->lm, row_begin, row_end);
+}
+
+static void *raster_worker(void *arg) {
+    RasterWorkerArg *worker = (RasterWorkerArg*)arg;
+    LEDRasterPool *pool = worker->pool;
+    int band = worker->band;
+    free(worker);
+
+    unsigned long seen = 0;
+    pthread_mutex_lock(&pool->lock);
+    while (1) {
+        while (!pool->quit && pool->generation == seen) {
+            pthread_cond_wait(&pool->work_cv, &pool->lock);
+        }
+        if (pool->quit) {
+            break;
+        }
+        seen = pool->generation;
+        pthread_mutex_unlock(&pool->lock);
+
+        raster_band(pool, band);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->pending == 0) {
+            pthread_cond_signal(&pool->done_cv);
+        }
+    }
+    pthread_mutex_unlock(&pool->lock);
+    return NULL;
+}
+
+LEDRasterPool *led_raster_pool_init(LEDMatrix *lm, int n_threads) {
+    LEDRasterPool *pool = (LEDRasterPool*)calloc(1, sizeof(LEDRasterPool));
+    if (!pool) {
+        return NULL;
+    }
+    pool->lm = lm;
+    pool->n_threads = n_threads;
+    pool->threads = (pthread_t*)calloc(n_threads, sizeof(pthread_t));
+    if (!pool->threads) {
+        free(pool);
+        return NULL;
+    }
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work_cv, NULL);
+    pthread_cond_init(&pool->done_cv, NULL);
+
+    // Band 0 is for the caller of led_raster_pool_run
+    for (int band=1; band<n_threads; band++) {
+        RasterWorkerArg *arg = (RasterWorkerArg*)malloc(sizeof(RasterWorkerArg));
+        if (!arg) {
+            led_raster_pool_end(pool);
+            return NULL;
+        }
+        arg->pool = pool;
+        arg->band = band;
+        if (pthread_create(&pool->threads[band], NULL, raster_worker, arg)) {
+            free(arg);
+            led_raster_pool_end(pool);
+            return NULL;
+        }
+        pool->n_started++;
+    }
+    return pool;
+}
+
+void led_raster_pool_run(LEDRasterPool *pool) {
+    LEDMatrix *lm = pool->lm;
+    if (lm->led_rows*lm->led_cols < LED_RASTER_MIN_PARALLEL) {
+        led_raster_rows(lm, 0, lm->led_rows);
+        return;
+    }
+
+    pthread_mutex_lock(&pool->lock);
+    pool->pending = pool->n_threads - 1;
+    pool->generation++;
+    pthread_cond_broadcast(&pool->work_cv);
+    pthread_mutex_unlock(&pool->lock);
+
+    raster_band(pool, 0);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->pending > 0) {
+        pthread_cond_wait(&pool->done_cv, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+void led_raster_pool_end(LEDRasterPool *pool) {
+    pthread_mutex_lock(&pool->lock);
+    pool->quit = 1;
+    pthread_cond_broadcast(&pool->work_cv);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int band=1; band<=pool->n_started; band++) {
+        pthread_join(pool->threads[band], NULL);
+    }
+    pthread_mutex_destroy(&pool->lock);
+    pthread_cond_destroy(&pool->work_cv);
+    pthread_cond_destroy(&pool->done_cv);
+    free(pool->threads);
+    free(pool);
+}
@@ -0,0 +1,352 @@
+/*
+ * This file is part of LEDCurses.
+ *
+ * LEDCurses is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LEDCurses is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LEDCurses.  If not, see <https://www.gnu.org/licenses/>.
+ * */
+
+#define _GNU_SOURCE // recvmmsg
+#include <arpa/inet.h>
+#include <errno.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "ledrecv.h"
+
+#define RECV_BUFFER_SIZE    (4 << 20)   // kernel buffer, room for bursts
+#define SEQUENCE_WINDOW     20          // E1.31 6.7.2: this far behind is a late packet
+
+// Art-Net
+#define ARTNET_ID           "Art-Net"   // followed by a NUL
+#define ARTNET_OP_DMX       0x5000
+#define ARTNET_OP_SYNC      0x5200
+#define ARTNET_DMX_HEADER   18
+
+// E1.31 (offsets into the whole packet)
+#define E131_ACN_ID         "ASC-E1.17\0\0\0"
+#define E131_ROOT_DATA      0x00000004
+#define E131_ROOT_EXTENDED  0x00000008
+#define E131_FRAMING_DATA   0x00000002
+#define E131_EXTENDED_SYNC  0x00000001
+#define E131_OPT_TERMINATED 0x40
+#define E131_OPT_PREVIEW    0x80
+#define E131_DATA_HEADER    126
+
+static inline unsigned get16(const uint8_t *p) {
+    return (p[0] << 8) | p[1];
+}
+
+static inline uint32_t get32(const uint8_t *p) {
+    return ((uint32_t)p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+}
+
+int led_recv_color_mono(const uint8_t *channels, void *arg) {
+    int n_channels = arg ? *(int*)arg : 1;
+    for (int c=0; c<n_channels; c++) {
+        if (channels[c] >= 128) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+int led_recv_init(LEDReceiver *rx, LEDMatrix *lm, int protocol, const char *addr, int port) {
+    if (!rx || !lm || (protocol != LED_RECV_ARTNET && protocol != LED_RECV_E131)) {
+        return 1;
+    }
+    if (!lm->matrix) {
+        err(lm, "The receiver needs a Diode matrix, not a mono one\n");
+        return 1;
+    }
+    rx->lm = lm;
+    rx->protocol = protocol;
+    rx->pixel_map = NULL;
+    rx->arrived = NULL;
+    rx->n_packets = 0;
+    rx->n_ignored = 0;
+    rx->n_frames = 0;
+    rx->n_torn = 0;
+    rx->sequence = -1;
+    rx->synced = 0;
+    rx->complete = 0;
+    rx->fd = -1;
+    rx->packets = (uint8_t*)malloc(LED_RECV_BATCH*LED_RECV_PACKET_SIZE);
+    if (!rx->packets || led_recv_set_map(rx, protocol == LED_RECV_ARTNET ? 0 : 1, 3, 0, NULL)) {
+        err(lm, "Couldn't allocate receiver\n");
+        led_recv_end(rx);
+        return 1;
+    }
+    led_recv_set_color(rx, led_recv_color_mono, &rx->channels_per_pixel);
+
+    struct sockaddr_in sin;
+    memset(&sin, 0, sizeof(sin));
+    sin.sin_family = AF_INET;
+    sin.sin_port = htons(port ? port : (protocol == LED_RECV_ARTNET ?
+                                        LED_RECV_ARTNET_PORT : LED_RECV_E131_PORT));
+    sin.sin_addr.s_addr = htonl(INADDR_ANY);
+    if (addr && inet_pton(AF_INET, addr, &sin.sin_addr) != 1) {
+        err(lm, "Invalid receiver address\n");
+        led_recv_end(rx);
+        return 1;
+    }
+
+    rx->fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+    if (rx->fd < 0) {
+        err(lm, "Couldn't create receiver socket\n");
+        led_recv_end(rx);
+        return 1;
+    }
+    int one = 1;
+    int buffer_size = RECV_BUFFER_SIZE;
+    setsockopt(rx->fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    // Best effort: capped by net.core.rmem_max
+    setsockopt(rx->fd, SOL_SOCKET, SO_RCVBUF, &buffer_size, sizeof(buffer_size));
+    if (bind(rx->fd, (struct sockaddr*)&sin, sizeof(sin))) {
+        err(lm, "Couldn't bind receiver socket\n");
+        led_recv_end(rx);
+        return 1;
+    }
+    return 0;
+}
+
+int led_recv_set_map(LEDReceiver *rx, int first_universe, int channels_per_pixel,
+                                      int pixels_per_universe, const int *pixel_map) {
+    if (channels_per_pixel != 1 && channels_per_pixel != 3) {
+        return 1;
+    }
+    int max_pixels = LED_RECV_CHANNELS/channels_per_pixel;
+    if (pixels_per_universe <= 0 || pixels_per_universe > max_pixels) {
+        pixels_per_universe = max_pixels;
+    }
+    int n_pixels = rx->lm->led_rows*rx->lm->led_cols;
+    int n_universes = (n_pixels + pixels_per_universe - 1)/pixels_per_universe;
+
+    int *map = (int*)malloc((n_pixels ? n_pixels : 1)*sizeof(int));
+    uint64_t *arrived = (uint64_t*)calloc((n_universes + 63)/64 + 1, sizeof(uint64_t));
+    if (!map || !arrived) {
+        free(map);
+        free(arrived);
+        return 1;
+    }
+    for (int i=0; i<n_pixels; i++) {
+        map[i] = pixel_map ? pixel_map[i] : i;
+        if (map[i] >= n_pixels) {
+            map[i] = -1;
+        }
+    }
+    free(rx->pixel_map);
+    free(rx->arrived);
+    rx->pixel_map = map;
+    rx->arrived = arrived;
+    rx->n_arrived = 0;
+    rx->sequence = -1;
+    rx->complete = 0;
+    rx->first_universe = first_universe;
+    rx->channels_per_pixel = channels_per_pixel;
+    rx->pixels_per_universe = pixels_per_universe;
+    rx->n_pixels = n_pixels;
+    rx->n_universes = n_universes;
+    return 0;
+}
+
+void led_recv_set_color(LEDReceiver *rx, LEDRecvColor color, void *arg) {
+    rx->color = color;
+    rx->color_arg = arg;
+}
+
+static void present(LEDReceiver *rx) {
+    led_draw(rx->lm);
+    rx->n_frames++;
+    memset(rx->arrived, 0, ((rx->n_universes + 63)/64)*sizeof(uint64_t));
+    rx->n_arrived = 0;
+    rx->complete = 0;
+}
+
+static void on_sync(LEDReceiver *rx) {
+    rx->synced = 1;
+    if (rx->complete) {
+        present(rx);
+    }
+}
+
+/* The next frame started before this one was done (or synced).
+ * */
+static void next_frame(LEDReceiver *rx) {
+    if (rx->complete) {
+        present(rx);
+    } else {
+        rx->n_torn++;
+        memset(rx->arrived, 0, ((rx->n_universes + 63)/64)*sizeof(uint64_t));
+        rx->n_arrived = 0;
+    }
+}
+
+/* `sequence` is the packet's sequence number, -1 if it has none.
+ * */
+static void on_universe(LEDReceiver *rx, int universe, int sequence, const uint8_t *data, int length) {
+    int u = universe - rx->first_universe;
+    if (u < 0 || u >= rx->n_universes) {
+        rx->n_ignored++;
+        return;
+    }
+    uint64_t bit = (uint64_t)1 << (u & 63);
+    if (sequence >= 0 && rx->sequence >= 0) {
+        int8_t ahead = (int8_t)(sequence - rx->sequence);
+        if (ahead == 0 ? !rx->n_arrived || (rx->arrived[u >> 6] & bit)
+                       : ahead < 0 && ahead > -SEQUENCE_WINDOW) {
+            // A duplicate, or a late universe of a frame already gone
+            rx->n_ignored++;
+            return;
+        }
+        if (ahead && rx->n_arrived) {
+            next_frame(rx);
+        }
+    } else if (rx->arrived[u >> 6] & bit) {
+        next_frame(rx);
+    }
+    rx->sequence = sequence;
+
+    LEDMatrix *lm = rx->lm;
+    int first = u*rx->pixels_per_universe;
+    int n = length/rx->channels_per_pixel;
+    if (n > rx->pixels_per_universe) n = rx->pixels_per_universe;
+    if (first + n > rx->n_pixels) n = rx->n_pixels - first;
+    for (int i=0; i<n; i++) {
+        int index = rx->pixel_map[first + i];
+        if (index < 0) {
+            continue;
+        }
+        int value = rx->color(data + i*rx->channels_per_pixel, rx->color_arg);
+        int row = index/lm->led_cols;
+        int col = index%lm->led_cols;
+        // Don't dirty the rows that didn't change
+        if (led_diode_at(lm, row, col)->value != value) {
+            led_diode_set_value_fast(lm, row, col, value);
+        }
+    }
+
+    rx->arrived[u >> 6] |= bit;
+    if (++rx->n_arrived == rx->n_universes) {
+        rx->complete = 1;
+        if (!rx->synced) {
+            present(rx);
+        }
+    }
+}
+
+static void decode_artnet(LEDReceiver *rx, const uint8_t *p, int size) {
+    if (size < 12 || memcmp(p, ARTNET_ID, sizeof(ARTNET_ID))) {
+        rx->n_ignored++;
+        return;
+    }
+    unsigned opcode = p[8] | (p[9] << 8);
+    if (opcode == ARTNET_OP_SYNC) {
+        on_sync(rx);
+        return;
+    }
+    if (opcode != ARTNET_OP_DMX || size < ARTNET_DMX_HEADER) {
+        rx->n_ignored++;
+        return;
+    }
+    int universe = p[14] | ((p[15] & 0x7f) << 8); // Net:SubUni
+    int sequence = p[12] ? p[12] : -1; // 0: the sender doesn't number them
+    int length = get16(p + 16);
+    if (length > size - ARTNET_DMX_HEADER) length = size - ARTNET_DMX_HEADER;
+    on_universe(rx, universe, sequence, p + ARTNET_DMX_HEADER, length);
+}
+
+static void decode_e131(LEDReceiver *rx, const uint8_t *p, int size) {
+    if (size < 49 || get16(p) != 0x0010 || memcmp(p + 4, E131_ACN_ID, 12)) {
+        rx->n_ignored++;
+        return;
+    }
+    uint32_t root_vector = get32(p + 18);
+    uint32_t framing_vector = get32(p + 40);
+    if (root_vector == E131_ROOT_EXTENDED && framing_vector == E131_EXTENDED_SYNC) {
+        on_sync(rx);
+        return;
+    }
+    if (root_vector != E131_ROOT_DATA || framing_vector != E131_FRAMING_DATA
+                                      || size < E131_DATA_HEADER) {
+        rx->n_ignored++;
+        return;
+    }
+    uint8_t options = p[112];
+    int start_code = p[125];
+    if ((options & (E131_OPT_TERMINATED | E131_OPT_PREVIEW)) || start_code != 0) {
+        rx->n_ignored++;
+        return;
+    }
+    // Only the sync address (non zero) tells us the source uses sync packets
+    if (get16(p + 109)) {
+        rx->synced = 1;
+    }
+    int length = (int)get16(p + 123) - 1; // the count includes the start code
+    if (length > size - E131_DATA_HEADER) length = size - E131_DATA_HEADER;
+    on_universe(rx, get16(p + 113), p[111], p + E131_DATA_HEADER, length);
+}
+
+int led_recv_poll(LEDReceiver *rx, int timeout_ms) {
+    struct pollfd pfd = {.fd = rx->fd, .events = POLLIN};
+    if (poll(&pfd, 1, timeout_ms) < 0) {
+        return errno == EINTR ? 0 : -1;
+    }
+
+    struct mmsghdr msgs[LED_RECV_BATCH];
+    struct iovec iovs[LED_RECV_BATCH];
+    memset(msgs, 0, sizeof(msgs));
+    for (int m=0; m<LED_RECV_BATCH; m++) {
+        iovs[m].iov_base = rx->packets + m*LED_RECV_PACKET_SIZE;
+        iovs[m].iov_len = LED_RECV_PACKET_SIZE;
+        msgs[m].msg_hdr.msg_iov = &iovs[m];
+        msgs[m].msg_hdr.msg_iovlen = 1;
+    }
+
+    uint64_t frames_before = rx->n_frames;
+    // Drain the socket: a full batch means there may be more
+    int n;
+    do {
+        n = recvmmsg(rx->fd, msgs, LED_RECV_BATCH, MSG_DONTWAIT, NULL);
+        if (n < 0) {
+            if (errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR) {
+                break;
+            }
+            return -1;
+        }
+        for (int m=0; m<n; m++) {
+            const uint8_t *p = rx->packets + m*LED_RECV_PACKET_SIZE;
+            int size = (int)msgs[m].msg_len;
+            rx->n_packets++;
+            if (rx->protocol == LED_RECV_ARTNET) {
+                decode_artnet(rx, p, size);
+            } else {
+                decode_e131(rx, p, size);
+            }
+        }
+    } while (n == LED_RECV_BATCH);
+    return (int)(rx->n_frames - frames_before);
+}
+
+void led_recv_end(LEDReceiver *rx) {
+    if (rx->fd >= 0) {
+        close(rx->fd);
+    }
+    free(rx->packets);
+    free(rx->pixel_map);
+    free(rx->arrived);
+    rx->fd = -1;
+    rx->packets = NULL;
+    rx->pixel_map = NULL;
+    rx->arrived = NULL;
+}
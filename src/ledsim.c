@@ -0,0 +1,155 @@
+/*
+ * This file is part of LEDCurses.
+ *
+ * LEDCurses is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LEDCurses is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LEDCurses.  If not, see <https://www.gnu.org/licenses/>.
+ * */
+
+#include <ctype.h>  // isspace
+#include <string.h> // strncmp
+#include "ledsim.h"
+
+#define FNV_OFFSET 0xcbf29ce484222325ull
+#define FNV_PRIME 0x100000001b3ull
+
+static uint64_t fnv1a(uint64_t hash, const void *data, size_t size) {
+    const unsigned char *bytes = (const unsigned char*)data;
+    for (size_t i=0; i<size; i++) {
+        hash ^= bytes[i];
+        hash *= FNV_PRIME;
+    }
+    return hash;
+}
+
+int led_sim_init(LEDSim *sim, int max_frames) {
+    if (!sim || max_frames <= 0) {
+        return 1;
+    }
+    sim->now_ms = 0;
+    sim->script = NULL;
+    sim->n_events = 0;
+    sim->next_event = 0;
+    sim->quit_key = ERR;
+    sim->blocking = 0;
+    sim->n_frames = 0;
+    sim->session_hash = FNV_OFFSET;
+    sim->max_frames = max_frames;
+    sim->frames = (LEDSimFrame*)calloc(max_frames, sizeof(LEDSimFrame));
+    return sim->frames ? 0 : 1;
+}
+
+static int parse_key(const char *token, int len) {
+    static const struct { const char *name; int key; } names[] = {
+        {"UP", KEY_UP}, {"DOWN", KEY_DOWN}, {"LEFT", KEY_LEFT}, {"RIGHT", KEY_RIGHT},
+        {"ENTER", '\n'}, {"SPACE", ' '},
+    };
+    if (len == 1) {
+        return (unsigned char)token[0];
+    }
+    if (token[0] == '#') {
+        return atoi(token + 1);
+    }
+    for (size_t i=0; i<sizeof(names)/sizeof(names[0]); i++) {
+        if ((int)strlen(names[i].name) == len && !strncmp(token, names[i].name, len)) {
+            return names[i].key;
+        }
+    }
+    return ERR;
+}
+
+int led_sim_parse_script(LEDSim *sim, const char *script) {
+    const char *p = script;
+    while (*p) {
+        while (isspace((unsigned char)*p)) p++;
+        if (!*p) break;
+
+        char *colon;
+        unsigned long long at_ms = strtoull(p, &colon, 10);
+        if (colon == p || *colon != ':') {
+            return 1;
+        }
+        const char *token = colon + 1;
+        int len = 0;
+        while (token[len] && !isspace((unsigned char)token[len])) len++;
+        int key = len ? parse_key(token, len) : ERR;
+        if (key == ERR) {
+            return 1;
+        }
+
+        LEDSimEvent *script_events = (LEDSimEvent*)realloc(sim->script,
+                                                           (sim->n_events+1)*sizeof(LEDSimEvent));
+        if (!script_events) {
+            return 1;
+        }
+        sim->script = script_events;
+        sim->script[sim->n_events].at_ms = at_ms;
+        sim->script[sim->n_events].key = key;
+        sim->n_events++;
+        p = token + len;
+    }
+    return 0;
+}
+
+void led_sim_attach(LEDMatrix *lm, LEDSim *sim) {
+    lm->sim = sim;
+}
+
+int led_sim_getch(LEDSim *sim) {
+    if (sim->next_event >= sim->n_events) {
+        return sim->quit_key;
+    }
+    LEDSimEvent *event = &sim->script[sim->next_event];
+    if (event->at_ms > sim->now_ms) {
+        if (!sim->blocking) {
+            return ERR;
+        }
+        sim->now_ms = event->at_ms;
+    }
+    sim->next_event++;
+    return event->key;
+}
+
+void led_sim_hash_frame(LEDSim *sim, LEDMatrix *lm) {
+    uint64_t hash = FNV_OFFSET;
+    if (lm->matrix) {
+        hash = fnv1a(hash, lm->matrix, (size_t)lm->led_rows*lm->led_cols*sizeof(Diode));
+    } else {
+        hash = fnv1a(hash, lm->mono_bits, (size_t)lm->led_rows*lm->mono_words*sizeof(uint64_t));
+    }
+    hash = fnv1a(hash, lm->cells, (size_t)lm->win_rows*lm->win_cols*sizeof(chtype));
+
+    LEDSimFrame *frame = &sim->frames[sim->n_frames % sim->max_frames];
+    frame->frame = sim->n_frames++;
+    frame->at_ms = sim->now_ms;
+    frame->hash = hash;
+    sim->session_hash = fnv1a(sim->session_hash, &hash, sizeof(hash));
+}
+
+int led_sim_write_hashes(LEDSim *sim, FILE *out) {
+    uint64_t first = sim->n_frames > (uint64_t)sim->max_frames ? sim->n_frames - sim->max_frames : 0;
+    for (uint64_t i=first; i<sim->n_frames; i++) {
+        LEDSimFrame *frame = &sim->frames[i % sim->max_frames];
+        fprintf(out, "%llu %llu %016llx\n", (unsigned long long)frame->frame,
+                (unsigned long long)frame->at_ms, (unsigned long long)frame->hash);
+    }
+    fprintf(out, "session %016llx\n", (unsigned long long)sim->session_hash);
+    return ferror(out) ? 1 : 0;
+}
+
+void led_sim_end(LEDSim *sim) {
+    free(sim->script);
+    free(sim->frames);
+    sim->script = NULL;
+    sim->frames = NULL;
+    sim->n_events = 0;
+}
@@ -0,0 +1,215 @@
+/*
+ * This file is part of LEDCurses.
+ *
+ * LEDCurses is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LEDCurses is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LEDCurses.  If not, see <https://www.gnu.org/licenses/>.
+ * */
+
+#include <stdio.h>
+#include <string.h>     // memcmp
+#include <fcntl.h>      // open
+#include <unistd.h>     // close
+#include <sys/mman.h>   // mmap
+#include <sys/stat.h>   // fstat
+#include "ledsprite.h"
+
+typedef struct atlas_header {
+    char magic[4];
+    uint32_t version;
+    uint32_t n_sprites;
+    uint32_t reserved;
+} AtlasHeader;
+
+typedef struct atlas_entry {
+    uint16_t rows;
+    uint16_t cols;
+    uint8_t transparent;
+    uint8_t flags;
+    uint16_t reserved;
+    uint32_t values_offset;
+    uint32_t attrs_offset;
+} AtlasEntry;
+
+int led_atlas_load(LEDAtlas *atlas, const char *path) {
+    atlas->sprites = NULL;
+    atlas->n_sprites = 0;
+    atlas->map = NULL;
+    atlas->map_size = 0;
+
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) {
+        return 1;
+    }
+    struct stat st;
+    if (fstat(fd, &st) || (size_t)st.st_size < sizeof(AtlasHeader)) {
+        close(fd);
+        return 1;
+    }
+    void *map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        return 1;
+    }
+    atlas->map = map;
+    atlas->map_size = st.st_size;
+
+    const AtlasHeader *header = (const AtlasHeader*)map;
+    if (memcmp(header->magic, "LEDA", 4) || header->version != LED_ATLAS_VERSION ||
+        header->n_sprites > (atlas->map_size - sizeof(AtlasHeader))/sizeof(AtlasEntry)) {
+        led_atlas_end(atlas);
+        return 1;
+    }
+
+    atlas->sprites = (LEDSprite*)calloc(header->n_sprites ? header->n_sprites : 1, sizeof(LEDSprite));
+    if (!atlas->sprites) {
+        led_atlas_end(atlas);
+        return 1;
+    }
+    const AtlasEntry *entries = (const AtlasEntry*)(header + 1);
+    for (uint32_t i=0; i<header->n_sprites; i++) {
+        const AtlasEntry *entry = &entries[i];
+        size_t n_pixels = (size_t)entry->rows*entry->cols;
+        // Everything must lie inside the file
+        if (entry->values_offset > atlas->map_size ||
+            n_pixels > atlas->map_size - entry->values_offset) {
+            led_atlas_end(atlas);
+            return 1;
+        }
+        if ((entry->flags & LED_ATLAS_HAS_ATTRS) &&
+            (entry->attrs_offset % 4 || entry->attrs_offset > atlas->map_size ||
+             n_pixels > (atlas->map_size - entry->attrs_offset)/4)) {
+            led_atlas_end(atlas);
+            return 1;
+        }
+        LEDSprite *sprite = &atlas->sprites[i];
+        sprite->rows = entry->rows;
+        sprite->cols = entry->cols;
+        sprite->transparent = entry->transparent;
+        sprite->values = (const uint8_t*)map + entry->values_offset;
+        sprite->attrs = (entry->flags & LED_ATLAS_HAS_ATTRS) ?
+                        (const uint32_t*)((const char*)map + entry->attrs_offset) : NULL;
+    }
+    atlas->n_sprites = header->n_sprites;
+    return 0;
+}
+
+int led_atlas_save(const char *path, const LEDSprite *sprites, int n_sprites) {
+    // Everything must fit its field in the file, or led_atlas_load would misread it
+    if (n_sprites < 0 || (n_sprites > 0 && !sprites)) {
+        return 1;
+    }
+    uint64_t size = sizeof(AtlasHeader) + (uint64_t)n_sprites*sizeof(AtlasEntry) + 3;
+    for (int i=0; i<n_sprites; i++) {
+        const LEDSprite *sprite = &sprites[i];
+        if (sprite->rows < 0 || sprite->rows > UINT16_MAX ||
+            sprite->cols < 0 || sprite->cols > UINT16_MAX ||
+            sprite->transparent < 0 || sprite->transparent > UINT8_MAX ||
+            (!sprite->values && sprite->rows && sprite->cols)) {
+            return 1;
+        }
+        size += (uint64_t)sprite->rows*sprite->cols*(sprite->attrs ? 5 : 1);
+    }
+    if (size > UINT32_MAX) {
+        return 1;
+    }
+
+    FILE *out = fopen(path, "wb");
+    if (!out) {
+        return 1;
+    }
+    AtlasHeader header = {{'L', 'E', 'D', 'A'}, LED_ATLAS_VERSION, (uint32_t)n_sprites, 0};
+    fwrite(&header, sizeof(header), 1, out);
+
+    // Values right after the entries, then all the attrs (aligned)
+    uint32_t offset = sizeof(AtlasHeader) + n_sprites*sizeof(AtlasEntry);
+    for (int i=0; i<n_sprites; i++) {
+        offset += sprites[i].rows*sprites[i].cols;
+    }
+    offset = (offset + 3) & ~3u;
+    uint32_t values_offset = sizeof(AtlasHeader) + n_sprites*sizeof(AtlasEntry);
+    uint32_t attrs_offset = offset;
+    for (int i=0; i<n_sprites; i++) {
+        uint32_t n_pixels = sprites[i].rows*sprites[i].cols;
+        AtlasEntry entry = {(uint16_t)sprites[i].rows, (uint16_t)sprites[i].cols,
+                            (uint8_t)sprites[i].transparent,
+                            sprites[i].attrs ? LED_ATLAS_HAS_ATTRS : 0, 0,
+                            values_offset, sprites[i].attrs ? attrs_offset : 0};
+        fwrite(&entry, sizeof(entry), 1, out);
+        values_offset += n_pixels;
+        if (sprites[i].attrs) {
+            attrs_offset += 4*n_pixels;
+        }
+    }
+    for (int i=0; i<n_sprites; i++) {
+        fwrite(sprites[i].values, 1, sprites[i].rows*sprites[i].cols, out);
+    }
+    for (uint32_t pad=values_offset; pad<offset; pad++) {
+        fputc(0, out);
+    }
+    for (int i=0; i<n_sprites; i++) {
+        if (sprites[i].attrs) {
+            fwrite(sprites[i].attrs, 4, sprites[i].rows*sprites[i].cols, out);
+        }
+    }
+    int failed = ferror(out);
+    return (fclose(out) || failed) ? 1 : 0;
+}
+
+void led_atlas_end(LEDAtlas *atlas) {
+    if (atlas->map) {
+        munmap(atlas->map, atlas->map_size);
+    }
+    free(atlas->sprites);
+    atlas->sprites = NULL;
+    atlas->n_sprites = 0;
+    atlas->map = NULL;
+    atlas->map_size = 0;
+}
+
+void led_blit_sprite(LEDMatrix *lm, const LEDSprite *sprite, int row, int col) {
+    if (!lm->matrix) {
+        return;
+    }
+    // Clip against the matrix
+    int first_row = row < 0 ? -row : 0;
+    int first_col = col < 0 ? -col : 0;
+    int last_row = sprite->rows;
+    int last_col = sprite->cols;
+    if (row + last_row > lm->led_rows) last_row = lm->led_rows - row;
+    if (col + last_col > lm->led_cols) last_col = lm->led_cols - col;
+    if (first_row >= last_row || first_col >= last_col) {
+        return;
+    }
+
+    for (int i=first_row; i<last_row; i++) {
+        const uint8_t *values = sprite->values + i*sprite->cols;
+        // dst[k] is the diode under pixel first_col + k (col may be negative)
+        Diode *dst = &lm->matrix[(row + i)*lm->led_cols + col + first_col];
+        if (sprite->attrs) {
+            const uint32_t *attrs = sprite->attrs + i*sprite->cols;
+            for (int j=first_col; j<last_col; j++) {
+                if (values[j] != sprite->transparent) {
+                    dst[j - first_col].value = values[j];
+                    dst[j - first_col].ch_attrs = attrs[j];
+                }
+            }
+        } else {
+            for (int j=first_col; j<last_col; j++) {
+                if (values[j] != sprite->transparent) {
+                    dst[j - first_col].value = values[j];
+                }
+            }
+        }
+    }
+    led_mark_dirty(lm, row + first_row, row + last_row);
+}
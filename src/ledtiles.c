@@ -0,0 +1,210 @@
+/*
+ * This file is part of LEDCurses.
+ *
+ * LEDCurses is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LEDCurses is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LEDCurses.  If not, see <https://www.gnu.org/licenses/>.
+ * */
+
+#include "ledtiles.h"
+
+int led_tiles_init(LEDTiledDisplay *display, int led_rows, int led_cols, int max_tiles) {
+    if (!display || led_rows <= 0 || led_cols <= 0 || max_tiles <= 0) {
+        return 1;
+    }
+    display->led_rows = led_rows;
+    display->led_cols = led_cols;
+    display->n_tiles = 0;
+    display->max_tiles = max_tiles;
+    display->matrix = (Diode*)calloc(led_rows*led_cols, sizeof(Diode));
+    display->tile_of = (int*)malloc(led_rows*led_cols*sizeof(int));
+    display->tiles = (LEDTile*)calloc(max_tiles, sizeof(LEDTile));
+    if (!display->matrix || !display->tile_of || !display->tiles) {
+        led_tiles_end(display);
+        return 1;
+    }
+    for (int i=0; i<led_rows*led_cols; i++) {
+        display->tile_of[i] = -1;
+    }
+    return 0;
+}
+
+/* Which cell of the region (rows x cols) is shown at (p_row, p_col) of the panel
+ * */
+static void panel_to_region(int transform, int rows, int cols, int p_cols,
+                            int p_row, int p_col, int *row, int *col) {
+    if (transform & LED_TILE_MIRROR) {
+        p_col = p_cols - 1 - p_col;
+    }
+    switch (transform & 3) {
+        case LED_TILE_ROT_0:
+            *row = p_row;
+            *col = p_col;
+            break;
+        case LED_TILE_ROT_90:
+            *row = rows - 1 - p_col;
+            *col = p_row;
+            break;
+        case LED_TILE_ROT_180:
+            *row = rows - 1 - p_row;
+            *col = cols - 1 - p_col;
+            break;
+        case LED_TILE_ROT_270:
+            *row = p_col;
+            *col = cols - 1 - p_row;
+            break;
+    }
+}
+
+int led_tiles_add(LEDTiledDisplay *display, LEDMatrix *panel, SCREEN *screen,
+                                            int row, int col, int transform) {
+    if (display->n_tiles >= display->max_tiles) {
+        err(panel, "No room for more tiles\n");
+        return -1;
+    }
+    if (!panel->matrix) {
+        err(panel, "Tiles need a Diode matrix, not a mono one\n");
+        return -1;
+    }
+
+    // Size of the region in the logical framebuffer
+    int quarter_turn = (transform & 3) == LED_TILE_ROT_90 || (transform & 3) == LED_TILE_ROT_270;
+    int rows = quarter_turn ? panel->led_cols : panel->led_rows;
+    int cols = quarter_turn ? panel->led_rows : panel->led_cols;
+    if (row < 0 || col < 0 || row + rows > display->led_rows || col + cols > display->led_cols) {
+        err(panel, "Tile doesn't fit in the display\n");
+        return -1;
+    }
+    for (int i=row; i<row + rows; i++) {
+        for (int j=col; j<col + cols; j++) {
+            if (display->tile_of[i*display->led_cols + j] >= 0) {
+                err(panel, "Tile overlaps another one\n");
+                return -1;
+            }
+        }
+    }
+
+    int index = display->n_tiles;
+    LEDTile *tile = &display->tiles[index];
+    tile->remap = (int*)malloc(rows*cols*sizeof(int));
+    if (!tile->remap) {
+        err(panel, "Couldn't allocate tile remap table\n");
+        return -1;
+    }
+    tile->panel = panel;
+    tile->screen = screen;
+    tile->row = row;
+    tile->col = col;
+    tile->rows = rows;
+    tile->cols = cols;
+    tile->transform = transform;
+    tile->dirty = 1;
+
+    for (int p_row=0; p_row<panel->led_rows; p_row++) {
+        for (int p_col=0; p_col<panel->led_cols; p_col++) {
+            int r_row, r_col;
+            panel_to_region(transform, rows, cols, panel->led_cols,
+                            p_row, p_col, &r_row, &r_col);
+            int logical = (row + r_row)*display->led_cols + col + r_col;
+            tile->remap[p_row*panel->led_cols + p_col] = logical;
+            display->tile_of[logical] = index;
+        }
+    }
+
+    display->n_tiles++;
+    return index;
+}
+
+Diode *led_tiles_get_diode(LEDTiledDisplay *display, int row, int col) {
+    if (row < 0 || row >= display->led_rows || col < 0 || col >= display->led_cols) {
+        return NULL;
+    }
+    int index = row*display->led_cols + col;
+    if (display->tile_of[index] >= 0) {
+        display->tiles[display->tile_of[index]].dirty = 1;
+    }
+    return &display->matrix[index];
+}
+
+void led_tiles_set_value(LEDTiledDisplay *display, int row, int col, int value) {
+    Diode *diode = led_tiles_get_diode(display, row, col);
+    if (!diode) return;
+    diode->value = value;
+}
+
+void led_tiles_set_attrs(LEDTiledDisplay *display, int row, int col, int attrs) {
+    Diode *diode = led_tiles_get_diode(display, row, col);
+    if (!diode) return;
+    diode->ch_attrs |= attrs;
+}
+
+void led_tiles_unset_attrs(LEDTiledDisplay *display, int row, int col, int attrs) {
+    Diode *diode = led_tiles_get_diode(display, row, col);
+    if (!diode) return;
+    diode->ch_attrs &= ~attrs;
+}
+
+void led_tiles_mark_dirty(LEDTiledDisplay *display, int row, int col, int rows, int cols) {
+    for (int t=0; t<display->n_tiles; t++) {
+        LEDTile *tile = &display->tiles[t];
+        if (row < tile->row + tile->rows && tile->row < row + rows &&
+            col < tile->col + tile->cols && tile->col < col + cols) {
+            tile->dirty = 1;
+        }
+    }
+}
+
+void led_tiles_draw(LEDTiledDisplay *display) {
+    for (int t=0; t<display->n_tiles; t++) {
+        LEDTile *tile = &display->tiles[t];
+        if (!tile->dirty) {
+            continue;
+        }
+        // Copy through the remap table, only flagging the panel rows that changed
+        LEDMatrix *panel = tile->panel;
+        for (int p_row=0; p_row<panel->led_rows; p_row++) {
+            Diode *dst = &panel->matrix[p_row*panel->led_cols];
+            const int *remap = &tile->remap[p_row*panel->led_cols];
+            int changed = 0;
+            for (int p_col=0; p_col<panel->led_cols; p_col++) {
+                Diode src = display->matrix[remap[p_col]];
+                changed |= (dst[p_col].value != src.value) | (dst[p_col].ch_attrs != src.ch_attrs);
+                dst[p_col] = src;
+            }
+            if (changed) {
+                led_mark_dirty(panel, p_row, p_row+1);
+            }
+        }
+
+        SCREEN *previous = tile->screen ? set_term(tile->screen) : NULL;
+        led_draw(panel);
+        if (previous) {
+            set_term(previous);
+        }
+        tile->dirty = 0;
+    }
+}
+
+void led_tiles_end(LEDTiledDisplay *display) {
+    if (display->tiles) {
+        for (int t=0; t<display->n_tiles; t++) {
+            free(display->tiles[t].remap);
+        }
+    }
+    free(display->matrix);
+    free(display->tile_of);
+    free(display->tiles);
+    display->matrix = NULL;
+    display->tile_of = NULL;
+    display->tiles = NULL;
+    display->n_tiles = 0;
+}
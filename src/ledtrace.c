@@ -0,0 +1,184 @@
+/*
+ * This file is part of LEDCurses.
+ *
+ * LEDCurses is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LEDCurses is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LEDCurses.  If not, see <https://www.gnu.org/licenses/>.
+ * */
+
+#include <string.h> // memset
+#include <time.h>   // clock_gettime
+#include "ledtrace.h"
+
+static const char *event_names[] = {"input", "mutate", "raster", "flush"};
+
+static uint64_t monotonic_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec*1000000000ull + ts.tv_nsec;
+}
+
+static int latency_bucket(uint64_t ns) {
+    if (ns < LED_TRACE_SUB_BUCKETS) {
+        return (int)ns;
+    }
+    int exp = 63 - __builtin_clzll(ns); // >= 3
+    int sub = (int)(ns >> (exp - 3)) - LED_TRACE_SUB_BUCKETS;
+    return (exp - 2)*LED_TRACE_SUB_BUCKETS + sub;
+}
+
+static uint64_t bucket_lower_bound(int bucket) {
+    if (bucket < LED_TRACE_SUB_BUCKETS) {
+        return bucket;
+    }
+    int exp = bucket/LED_TRACE_SUB_BUCKETS + 2;
+    uint64_t sub = bucket%LED_TRACE_SUB_BUCKETS + LED_TRACE_SUB_BUCKETS;
+    return sub << (exp - 3);
+}
+
+static LEDTraceEvent *next_event(LEDTrace *trace) {
+    return &trace->events[trace->n_events++ % trace->capacity];
+}
+
+int led_trace_init(LEDTrace *trace, uint32_t capacity) {
+    if (!trace || capacity == 0) {
+        return 1;
+    }
+    memset(trace, 0, sizeof(LEDTrace));
+    trace->events = (LEDTraceEvent*)calloc(capacity, sizeof(LEDTraceEvent));
+    if (!trace->events) {
+        return 1;
+    }
+    trace->capacity = capacity;
+    trace->start_ns = monotonic_ns();
+    return 0;
+}
+
+void led_trace_attach(LEDMatrix *lm, LEDTrace *trace) {
+    lm->trace = trace;
+}
+
+uint64_t led_trace_now(LEDTrace *trace) {
+    return monotonic_ns() - trace->start_ns;
+}
+
+void led_trace_input(LEDTrace *trace, int key) {
+    LEDTraceEvent *ev = next_event(trace);
+    ev->begin_ns = led_trace_now(trace);
+    ev->dur_ns = 0;
+    ev->frame = trace->frame;
+    ev->arg = key;
+    ev->type = LED_TRACE_INPUT;
+    if (!trace->pending_input_ns) {
+        trace->pending_input_ns = ev->begin_ns;
+    }
+}
+
+void led_trace_mutation(LEDTrace *trace) {
+    if (trace->mutated) {
+        return;
+    }
+    trace->mutated = 1;
+    LEDTraceEvent *ev = next_event(trace);
+    ev->begin_ns = led_trace_now(trace);
+    ev->dur_ns = 0;
+    ev->frame = trace->frame;
+    ev->arg = 0;
+    ev->type = LED_TRACE_MUTATE;
+}
+
+void led_trace_span(LEDTrace *trace, int type, uint64_t begin_ns, int arg) {
+    LEDTraceEvent *ev = next_event(trace);
+    ev->begin_ns = begin_ns;
+    ev->dur_ns = (uint32_t)(led_trace_now(trace) - begin_ns);
+    ev->frame = trace->frame;
+    ev->arg = arg;
+    ev->type = type;
+}
+
+void led_trace_frame_end(LEDTrace *trace, uint64_t flush_end_ns) {
+    if (trace->pending_input_ns) {
+        uint64_t latency = flush_end_ns - trace->pending_input_ns;
+        trace->latency_hist[latency_bucket(latency)]++;
+        trace->latency_count++;
+        trace->latency_sum_ns += latency;
+        if (latency > trace->latency_max_ns) {
+            trace->latency_max_ns = latency;
+        }
+        trace->pending_input_ns = 0;
+    }
+    trace->mutated = 0;
+    trace->frame++;
+}
+
+uint64_t led_trace_latency_percentile(LEDTrace *trace, double p) {
+    if (trace->latency_count == 0) {
+        return 0;
+    }
+    uint64_t target = (uint64_t)(p/100.0*trace->latency_count);
+    uint64_t seen = 0;
+    for (int bucket=0; bucket<LED_TRACE_BUCKETS; bucket++) {
+        seen += trace->latency_hist[bucket];
+        if (seen > target) {
+            return bucket_lower_bound(bucket);
+        }
+    }
+    return trace->latency_max_ns;
+}
+
+int led_trace_export_json(LEDTrace *trace, FILE *out) {
+    uint64_t first = trace->n_events > trace->capacity ? trace->n_events - trace->capacity : 0;
+    fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    fprintf(out, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"ledcurses\"}}");
+    int flow_open = 0;   // an input of flow_frame started an arrow
+    uint32_t flow_frame = 0;
+    for (uint64_t i=first; i<trace->n_events; i++) {
+        LEDTraceEvent *ev = &trace->events[i % trace->capacity];
+        double ts_us = ev->begin_ns/1000.0;
+        if (ev->dur_ns) {
+            fprintf(out, ",\n{\"name\":\"%s\",\"cat\":\"frame\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,"
+                         "\"pid\":1,\"tid\":1,\"args\":{\"frame\":%u,\"n\":%d}}",
+                    event_names[ev->type], ts_us, ev->dur_ns/1000.0, ev->frame, ev->arg);
+        } else {
+            fprintf(out, ",\n{\"name\":\"%s\",\"cat\":\"frame\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,"
+                         "\"pid\":1,\"tid\":1,\"args\":{\"frame\":%u,\"n\":%d}}",
+                    event_names[ev->type], ts_us, ev->frame, ev->arg);
+        }
+        // An arrow from the first input of a frame to the flush that shows it.
+        // Frames without input (or whose input fell off the ring) get none.
+        if (ev->type == LED_TRACE_INPUT && !(flow_open && flow_frame == ev->frame)) {
+            flow_open = 1;
+            flow_frame = ev->frame;
+            fprintf(out, ",\n{\"name\":\"input-to-photon\",\"cat\":\"latency\",\"ph\":\"s\",\"id\":%u,"
+                         "\"ts\":%.3f,\"pid\":1,\"tid\":1}", ev->frame, ts_us);
+        } else if (ev->type == LED_TRACE_FLUSH && flow_open && flow_frame == ev->frame) {
+            flow_open = 0;
+            fprintf(out, ",\n{\"name\":\"input-to-photon\",\"cat\":\"latency\",\"ph\":\"f\",\"bp\":\"e\",\"id\":%u,"
+                         "\"ts\":%.3f,\"pid\":1,\"tid\":1}", ev->frame, (ev->begin_ns + ev->dur_ns)/1000.0);
+        }
+    }
+    fprintf(out, "\n],\"otherData\":{\"frames\":%u,\"latency_frames\":%llu,"
+                 "\"latency_mean_us\":%.3f,\"latency_p50_us\":%.3f,\"latency_p99_us\":%.3f,"
+                 "\"latency_max_us\":%.3f}}\n",
+            trace->frame, (unsigned long long)trace->latency_count,
+            trace->latency_count ? trace->latency_sum_ns/1000.0/trace->latency_count : 0.0,
+            led_trace_latency_percentile(trace, 50)/1000.0,
+            led_trace_latency_percentile(trace, 99)/1000.0,
+            trace->latency_max_ns/1000.0);
+    return ferror(out) ? 1 : 0;
+}
+
+void led_trace_end(LEDTrace *trace) {
+    free(trace->events);
+    trace->events = NULL;
+    trace->capacity = 0;
+}
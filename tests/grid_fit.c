@@ -0,0 +1,82 @@
+/*
+ * This file is part of LEDCurses.
+ *
+ * LEDCurses is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * LEDCurses is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with LEDCurses.  If not, see <https://www.gnu.org/licenses/>.
+ * */
+
+#include <stdio.h>
+#include <string.h>
+#include "ledcurses.h"
+
+/* A 2x10 matrix on 5 rows gets LEDs of size 2. With the grid, columns are
+ * 2*(2+1) cells apart, so it needs 2*3*10 - 2 = 58 columns: 58 just fits,
+ * 57 doesn't. Drawing everything on must not touch anything past lm->cells.
+ * */
+#define LED_ROWS 2
+#define LED_COLS 10
+#define WIN_ROWS 5
+#define GUARD 4096
+
+static int draw_all_on(int win_cols, int expect_grid) {
+    size_t size = led_mem_size(LED_ROWS, LED_COLS, WIN_ROWS, win_cols);
+    static unsigned char mem[1 << 16] __attribute__((aligned(16)));
+    if (size + GUARD > sizeof(mem)) {
+        printf("grid_fit: %d cols: memory too small\n", win_cols);
+        return 1;
+    }
+    memset(mem, 0xAA, sizeof(mem));
+
+    LEDMatrix lm;
+    if (led_init_headless(&lm, LED_ROWS, LED_COLS, WIN_ROWS, win_cols, mem, size)) {
+        printf("grid_fit: %d cols: init failed\n", win_cols);
+        return 1;
+    }
+    int failed = 0;
+    if (led_set_grid(&lm, 1) != !expect_grid) {
+        printf("grid_fit: %d cols: grid should %sbe available\n", win_cols, expect_grid ? "" : "not ");
+        failed = 1;
+    }
+    for (int i=0; i<LED_ROWS; i++) {
+        for (int j=0; j<LED_COLS; j++) {
+            led_diode_set_value(&lm, i, j, 1);
+        }
+    }
+    led_draw(&lm);
+
+    // The last diode ends on the last column
+    if (expect_grid && !lm.cells[(WIN_ROWS-1)*win_cols + win_cols-1]) {
+        printf("grid_fit: %d cols: last diode not drawn\n", win_cols);
+        failed = 1;
+    }
+    for (size_t k=size; k<size+GUARD; k++) {
+        if (mem[k] != 0xAA) {
+            printf("grid_fit: %d cols: wrote past the matrix memory\n", win_cols);
+            failed = 1;
+            break;
+        }
+    }
+    led_end(&lm);
+    return failed;
+}
+
+int main() {
+    int failed = 0;
+    failed |= draw_all_on(58, 1);
+    failed |= draw_all_on(57, 0);
+    failed |= draw_all_on(51, 0);
+    if (!failed) {
+        printf("grid_fit: ok\n");
+    }
+    return failed;
+}